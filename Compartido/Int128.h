@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * Enteros de 128 bits para los días que los necesitan. GCC y Clang los ofrecen como «__int128».
+ * MSVC no tiene un tipo nativo, así que usamos «std::_Unsigned128» y «std::_Signed128» de
+ * «<__msvc_int128.hpp>», la implementación que su biblioteca estándar usa internamente para los
+ * rangos con índices grandes. Es un detalle de implementación sin documentar, que puede cambiar
+ * entre versiones del compilador, y por eso sólo se depende de él en este fichero.
+ */
+
+#if defined(__SIZEOF_INT128__)
+typedef unsigned __int128 UInt128;
+typedef __int128 Int128;
+#else
+#include <__msvc_int128.hpp>
+typedef std::_Unsigned128 UInt128;
+typedef std::_Signed128 Int128;
+#endif
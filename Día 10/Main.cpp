@@ -1,131 +1,260 @@
 #include <array>
-#include <unordered_set>
+#include <vector>
+#include <string>
+#include <span>
+#include <bit>
+#include <cstdlib>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <cassert>
 
-constexpr uint8_t MAP_SIZE = 140;
+#if defined(__PCLMUL__)
+#include <immintrin.h>
+#endif
 
-struct Node
+// Si se activa, se construye el mapa de las casillas encerradas con el recorrido por paridad
+// y su cantidad se comprueba con la obtenida por el teorema de Pick.
+constexpr bool BUILD_INTERIOR_MAP = false;
+
+/*
+ * Cada casilla guarda sus conexiones en 4 bits, una por dirección, y el mapa guarda dos casillas
+ * por byte. Las dimensiones se leen de la entrada, así que un laberinto de 10000x10000 ocupa
+ * 50 MB. Las direcciones se numeran para poder recorrer el ciclo con tablas.
+ */
+
+enum Direction : uint8_t
 {
-    uint8_t up : 1;
-    uint8_t down : 1;
-    uint8_t left : 1;
-    uint8_t right : 1;
+    Up, Down, Left, Right
 };
 
-struct Coord {
-    uint8_t x, y;
-    bool operator==(const Coord& o) const noexcept { return x == o.x && y == o.y; }
+constexpr uint8_t UP = 1 << Up;
+constexpr uint8_t DOWN = 1 << Down;
+constexpr uint8_t LEFT = 1 << Left;
+constexpr uint8_t RIGHT = 1 << Right;
+
+constexpr std::array<int64_t, 4> DX = { 0, 0, -1, 1 };
+constexpr std::array<int64_t, 4> DY = { -1, 1, 0, 0 };
+constexpr std::array<Direction, 4> OPPOSITE = { Down, Up, Right, Left };
+
+// Dirección de salida de una casilla según sus conexiones y la dirección con la que llegamos:
+// la conexión que no es por la que hemos entrado.
+constexpr std::array<std::array<Direction, 4>, 16> EXIT = []
+{
+    std::array<std::array<Direction, 4>, 16> table{};
+    for (uint8_t connections = 0; connections < 16; connections++)
+    {
+        for (uint8_t arrival = 0; arrival < 4; arrival++)
+        {
+            const uint8_t remaining = connections & ~(1 << OPPOSITE[arrival]);
+            table[connections][arrival] = static_cast<Direction>(remaining == 0 ? arrival : std::countr_zero(remaining));
+        }
+    }
+
+    return table;
+}();
+
+class PipeMap
+{
+    size_t m_width;
+    size_t m_height = 0;
+    std::vector<uint8_t> m_cells;
+
+    [[nodiscard]] size_t RowBytes() const noexcept { return (m_width + 1) / 2; }
+
+public:
+    explicit PipeMap(const size_t width) : m_width(width) {}
+
+    [[nodiscard]] size_t Width() const noexcept { return m_width; }
+    [[nodiscard]] size_t Height() const noexcept { return m_height; }
+
+    void AddRow() { m_cells.resize(++m_height * RowBytes()); }
+
+    [[nodiscard]] uint8_t Get(const size_t x, const size_t y) const noexcept
+    {
+        return m_cells[y * RowBytes() + x / 2] >> (x % 2 * 4) & 0xF;
+    }
+
+    void Set(const size_t x, const size_t y, const uint8_t connections) noexcept
+    {
+        uint8_t& cell = m_cells[y * RowBytes() + x / 2];
+        cell = static_cast<uint8_t>((cell & ~(0xF << (x % 2 * 4))) | connections << (x % 2 * 4));
+    }
+
+    // Conexiones de la casilla vecina en una dirección, o ninguna si se sale del mapa.
+    [[nodiscard]] uint8_t Neighbour(const size_t x, const size_t y, const Direction direction) const noexcept
+    {
+        const int64_t nx = static_cast<int64_t>(x) + DX[direction];
+        const int64_t ny = static_cast<int64_t>(y) + DY[direction];
+
+        if (nx < 0 || ny < 0 || nx >= static_cast<int64_t>(m_width) || ny >= static_cast<int64_t>(m_height)) return 0;
+        return Get(static_cast<size_t>(nx), static_cast<size_t>(ny));
+    }
 };
 
-template<>
-struct std::hash<Coord>
+constexpr size_t WORD_BITS = 64;
+
+/**
+ * \brief Máscara de bits del mapa, con cada fila alineada a palabras de 64 bits.
+ */
+class RowMask
 {
-    size_t operator()(const Coord& a) const noexcept {
-        return std::hash<uint16_t>{}((a.x << 8) | a.y);
+    size_t m_rowWords;
+    std::vector<uint64_t> m_words;
+
+public:
+    RowMask(const size_t width, const size_t height)
+        : m_rowWords((width + WORD_BITS - 1) / WORD_BITS), m_words(m_rowWords * height)
+    {}
+
+    [[nodiscard]] size_t RowWords() const noexcept { return m_rowWords; }
+
+    void Set(const size_t x, const size_t y) noexcept
+    {
+        m_words[y * m_rowWords + x / WORD_BITS] |= static_cast<uint64_t>(1) << (x % WORD_BITS);
+    }
+
+    [[nodiscard]] bool Test(const size_t x, const size_t y) const noexcept
+    {
+        return m_words[y * m_rowWords + x / WORD_BITS] >> (x % WORD_BITS) & 1;
+    }
+
+    [[nodiscard]] std::span<uint64_t> Row(const size_t y) noexcept
+    {
+        return std::span(m_words).subspan(y * m_rowWords, m_rowWords);
+    }
+
+    [[nodiscard]] std::span<const uint64_t> Row(const size_t y) const noexcept
+    {
+        return std::span(m_words).subspan(y * m_rowWords, m_rowWords);
     }
 };
 
-typedef std::array<std::array<Node, MAP_SIZE>, MAP_SIZE> Map;
+typedef RowMask LoopMask;
+
+/*
+ * Mientras recorremos el ciclo marcamos sus casillas en un bitset y acumulamos el doble del
+ * área del polígono que forman los centros de las casillas con la fórmula del área de Gauss.
+ * Por el teorema de Pick, «A = I + B / 2 - 1», donde «B» son los puntos enteros del borde, las
+ * casillas del ciclo, e «I» los del interior, que son justo las casillas encerradas.
+ */
 
-static uint16_t First(const Map& map, std::unordered_set<Coord>& marked, uint8_t startX, uint8_t startY)
+struct Loop
 {
-    // Al ser un ciclo sin ramificaciones, elegimos una dirección y tiramos
+    uint64_t length = 0;
+    int64_t doubleArea = 0;
+};
 
-    uint16_t distance = 0;
+static Loop WalkLoop(const PipeMap& map, LoopMask& marked, const size_t startX, const size_t startY)
+{
+    // Al ser un ciclo sin ramificaciones, elegimos una dirección y tiramos
+    const uint8_t startConnections = map.Get(startX, startY);
+    if (startConnections == 0) throw std::exception("El inicio no está conectado");
 
-    uint8_t prevX = startX;
-    uint8_t prevY = startY;
+    Loop loop;
 
-    uint8_t x = startX;
-    uint8_t y = startY;
+    int64_t x = static_cast<int64_t>(startX);
+    int64_t y = static_cast<int64_t>(startY);
+    Direction direction = static_cast<Direction>(std::countr_zero(startConnections));
 
-    while (distance < MAP_SIZE * MAP_SIZE)
+    do
     {
-        marked.emplace(x, y);
-        const auto& node = map[y][x];
+        marked.Set(static_cast<size_t>(x), static_cast<size_t>(y));
 
-        // Comprobamos la conexión superior
-        if (node.up && y > 0 && map[y - 1][x].down && prevY != y - 1)
-        {
-            prevX = x;
-            prevY = y;
-            y -= 1;
-        }
-        // Comprobamos la conexión inferior
-        else if (node.down && y < MAP_SIZE - 1 && map[y + 1][x].up && prevY != y + 1)
-        {
-            prevX = x;
-            prevY = y;
-            y += 1;
-        }
-        // Comprobamos la conexión izquierda
-        else if (node.left  && x > 0 && map[y][x - 1].right && prevX != x - 1)
-        {
-            prevX = x;
-            prevY = y;
-            x -= 1;
-        }
-        // Comprobamos la conexión derecha
-        else if (node.right && x < MAP_SIZE - 1 && map[y][x + 1].left && prevX != x + 1)
-        {
-            prevX = x;
-            prevY = y;
-            x += 1;
-        }
+        const int64_t nx = x + DX[direction];
+        const int64_t ny = y + DY[direction];
 
-        distance++;
+        loop.length++;
+        loop.doubleArea += x * ny - nx * y;
 
-        if (x == startX && y == startY) {
-            assert(distance % 2 == 0);
-            return distance / 2;
-        }
+        x = nx;
+        y = ny;
+        direction = EXIT[map.Get(static_cast<size_t>(x), static_cast<size_t>(y))][direction];
     }
+    while (x != static_cast<int64_t>(startX) || y != static_cast<int64_t>(startY));
 
-    throw std::exception();
+    assert(loop.length % 2 == 0);
+    return loop;
 }
 
-static uint16_t Second(const Map& map, const std::unordered_set<Coord>& marked)
+static uint64_t First(const Loop& loop)
 {
-    uint16_t res = 0;
-    for (uint8_t i = 0; i < MAP_SIZE; i++)
-    {
-        const auto& row = map[i];
-        bool inside = false;
-        bool startedUp = false;
+    return loop.length / 2;
+}
 
-        for (uint8_t j = 0; j < MAP_SIZE; j++)
+static uint64_t Second(const Loop& loop)
+{
+    return static_cast<uint64_t>((std::llabs(loop.doubleArea) - static_cast<int64_t>(loop.length)) / 2 + 1);
+}
+
+/*
+ * Para obtener qué casillas están encerradas recorremos cada fila contando los cruces con el
+ * ciclo: una casilla está dentro si a su izquierda hay una cantidad impar de casillas del ciclo
+ * que conectan hacia arriba. Las tuberías horizontales no cruzan, y de cada par de esquinas
+ * «L7» o «FJ» sólo una conecta hacia arriba, así que los tramos horizontales se cuentan bien.
+ *
+ * Con las casillas del ciclo que conectan hacia arriba como máscara de bits, la paridad de cada
+ * posición es la XOR acumulada de la máscara, que calculamos por palabras de 64 bits. La paridad
+ * de las palabras anteriores de la fila se arrastra invirtiendo la palabra siguiente.
+ */
+
+/**
+ * \brief Calcula la XOR acumulada de los bits de una palabra, de menor a mayor.
+ */
+[[nodiscard]] inline uint64_t PrefixXor(uint64_t word) noexcept
+{
+#if defined(__PCLMUL__)
+    // Multiplicar sin acarreo por una palabra de unos suma en cada bit todos los anteriores.
+    const __m128i product = _mm_clmulepi64_si128(
+        _mm_cvtsi64_si128(static_cast<int64_t>(word)),
+        _mm_set1_epi64x(-1),
+        0x00
+    );
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+    for (uint32_t shift = 1; shift < WORD_BITS; shift *= 2)
+        word ^= word << shift;
+
+    return word;
+#endif
+}
+
+class InteriorMap
+{
+    RowMask m_inside;
+    uint64_t m_count = 0;
+
+public:
+    InteriorMap(const PipeMap& map, const LoopMask& marked) : m_inside(map.Width(), map.Height())
+    {
+        for (size_t y = 0; y < map.Height(); y++)
         {
-            const auto& node = row[j];
-            if (marked.contains({ j, i })) {
-                if (node.up && node.down) {
-                    inside = !inside;
-                }
-                else {
-                    if (node.up || node.down)
-                    {
-                        if (node.right)
-                            startedUp = node.up;
-                        else if (startedUp == node.down)
-                            inside = !inside;
-                    }
+            const auto loop = marked.Row(y);
+            const auto inside = m_inside.Row(y);
+
+            uint64_t parity = 0;
+            for (size_t w = 0; w < marked.RowWords(); w++)
+            {
+                // Las casillas del ciclo que conectan hacia arriba.
+                uint64_t north = 0;
+                for (uint64_t bits = loop[w]; bits != 0; bits &= bits - 1)
+                {
+                    const size_t bit = std::countr_zero(bits);
+                    north |= static_cast<uint64_t>((map.Get(w * WORD_BITS + bit, y) & UP) != 0) << bit;
                 }
-            }
-            else {
-                res += inside;
+
+                const uint64_t crossings = PrefixXor(north) ^ parity;
+                parity = 0 - (crossings >> (WORD_BITS - 1));
+
+                inside[w] = crossings & ~loop[w];
+                m_count += std::popcount(inside[w]);
             }
         }
     }
 
-    return res;
-}
-
-namespace
-{
-    Map g_map;
-}
+    [[nodiscard]] bool IsInside(const size_t x, const size_t y) const noexcept { return m_inside.Test(x, y); }
+    [[nodiscard]] uint64_t Count() const noexcept { return m_count; }
+};
 
 int main()
 {
@@ -135,51 +264,70 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    uint8_t startX = 0;
-    uint8_t startY = 0;
+    size_t startX = 0;
+    size_t startY = 0;
+
+    std::ifstream input("input", std::ios::binary);
+
+    std::string line;
+    std::getline(input, line);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
 
+    PipeMap map(line.size());
+
+    do
     {
-        std::ifstream input("input", std::ios::binary);
-        for (uint8_t i = 0; i < MAP_SIZE; i++)
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        assert(line.size() == map.Width());
+        const size_t i = map.Height();
+        map.AddRow();
+
+        for (size_t j = 0; j < map.Width(); j++)
         {
-            for (uint8_t j = 0; j < MAP_SIZE; j++)
+            switch (line[j])
             {
-                char c = static_cast<char>(input.get());
-                switch (c)
-                {
-                case '|': g_map[i][j] = { 1, 1, 0, 0 }; break;
-                case '-': g_map[i][j] = { 0, 0, 1, 1 }; break;
-                case 'L': g_map[i][j] = { 1, 0, 0, 1 }; break;
-                case 'J': g_map[i][j] = { 1, 0, 1, 0 }; break;
-                case '7': g_map[i][j] = { 0, 1, 1, 0 }; break;
-                case 'F': g_map[i][j] = { 0, 1, 0, 1 }; break;
-                default:  g_map[i][j] = { 0, 0, 0, 0 }; break;
-
-                case 'S':
-                    g_map[i][j] = { 1, 1, 1, 1 };
-                    startY = i;
-                    startX = j;
+            case '|': map.Set(j, i, UP | DOWN); break;
+            case '-': map.Set(j, i, LEFT | RIGHT); break;
+            case 'L': map.Set(j, i, UP | RIGHT); break;
+            case 'J': map.Set(j, i, UP | LEFT); break;
+            case '7': map.Set(j, i, DOWN | LEFT); break;
+            case 'F': map.Set(j, i, DOWN | RIGHT); break;
+            default: break;
+
+            case 'S':
+                startY = i;
+                startX = j;
                 break;
-                }
             }
-            input.ignore();
         }
     }
+    while (std::getline(input, line));
 
-    assert(startX > 0 && startX < MAP_SIZE - 1);
-    assert(startY > 0 && startY < MAP_SIZE - 1);
+    // El inicio conecta con las casillas vecinas que conectan con él.
+    uint8_t startConnections = 0;
+    for (uint8_t direction = 0; direction < 4; direction++)
+    {
+        const auto towards = static_cast<Direction>(direction);
+        if (map.Neighbour(startX, startY, towards) & 1 << OPPOSITE[towards])
+            startConnections |= 1 << towards;
+    }
+
+    map.Set(startX, startY, startConnections);
 
-    g_map[startY][startX] = {
-        g_map[startY - 1][startX].down,
-        g_map[startY + 1][startX].up,
-        g_map[startY][startX - 1].right,
-        g_map[startY][startX + 1].left,
-    };
+    LoopMask marked(map.Width(), map.Height());
+    const Loop loop = WalkLoop(map, marked, startX, startY);
 
-    std::unordered_set<Coord> marked;
+    if constexpr (BUILD_INTERIOR_MAP)
+    {
+        const InteriorMap interior(map, marked);
+        if (interior.Count() != Second(loop))
+            throw std::exception("El recorrido por paridad no coincide con el teorema de Pick");
+    }
 
-    std::cout << "Primera parte: " << First(g_map, marked, startX, startY) << std::endl;
-    std::cout << "Segunda parte: " << Second(g_map, marked) << std::endl;
+    std::cout << "Primera parte: " << First(loop) << std::endl;
+    std::cout << "Segunda parte: " << Second(loop) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
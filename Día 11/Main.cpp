@@ -1,76 +1,108 @@
 #include <vector>
-#include <set>
+#include <string>
 #include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 
-constexpr uint8_t MAP_LENGTH = 140;
-
-struct Coord { uint8_t x, y; };
+#include "../Compartido/Int128.h"
+
+/*
+ * La distancia de Manhattan se separa por ejes, así que la suma de las distancias entre todos
+ * los pares de galaxias es la suma de las distancias de sus filas más la de sus columnas. En cada
+ * eje sólo necesitamos cuántas galaxias hay en cada línea.
+ *
+ * Cada línea vacía entre dos galaxias añade «factor - 1» a su distancia, así que el total es
+ * lineal en el factor: la suma de distancias sin expandir más «factor - 1» por la cantidad de
+ * veces que un par cruza una línea vacía. Calculamos ambos coeficientes una vez, en 128 bits
+ * para que no desborden con mapas grandes, y cada factor se responde en O(1):
+ *
+ *   - La distancia sin expandir se obtiene recorriendo las líneas en orden: cada galaxia suma
+ *     la distancia a todas las anteriores con la cantidad y la suma de coordenadas de estas.
+ *   - Una línea vacía la cruzan todos los pares con una galaxia a cada lado.
+ */
+
+struct GalaxyCounts
+{
+    std::vector<uint64_t> rows;
+    std::vector<uint64_t> columns;
+};
 
-static uint32_t GetDistance(
-    Coord a, Coord b,
-    const std::vector<uint8_t>& emptyRows,
-    const std::vector<uint8_t>& emptyColumns,
-    uint32_t scaleFactor
-)
+class DistanceModel
 {
-    const auto& [minX, maxX] = std::minmax(a.x, b.x);
-    const auto& [minY, maxY] = std::minmax(a.y, b.y);
+    UInt128 m_base = 0;
+    UInt128 m_crossings = 0;
 
-    uint32_t increment = 0;
+    void AddAxis(const std::vector<uint64_t>& counts)
+    {
+        uint64_t total = 0;
+        for (const uint64_t count : counts) total += count;
+
+        uint64_t seen = 0;
+        UInt128 coordinateSum = 0;
+
+        for (uint64_t coordinate = 0; coordinate < counts.size(); coordinate++)
+        {
+            const uint64_t count = counts[coordinate];
+            if (count == 0)
+            {
+                m_crossings += static_cast<UInt128>(seen) * (total - seen);
+                continue;
+            }
 
-    if (minX != maxX) {
-        const auto& first = std::ranges::lower_bound(emptyColumns, minX);
-        const auto& last = std::ranges::upper_bound(emptyColumns, maxX);
+            m_base += count * (static_cast<UInt128>(coordinate) * seen - coordinateSum);
+            seen += count;
+            coordinateSum += static_cast<UInt128>(count) * coordinate;
+        }
+    }
 
-        assert(first <= last);
-        increment += (scaleFactor - 1) * static_cast<uint32_t>(last - first);
+public:
+    explicit DistanceModel(const GalaxyCounts& counts)
+    {
+        AddAxis(counts.rows);
+        AddAxis(counts.columns);
     }
 
-    if (minY != maxY) {
-        const auto& first = std::ranges::lower_bound(emptyRows, minY);
-        const auto& last = std::ranges::upper_bound(emptyRows, maxY);
+    [[nodiscard]] UInt128 Base() const noexcept { return m_base; }
+    [[nodiscard]] UInt128 Crossings() const noexcept { return m_crossings; }
 
-        assert(first <= last);
-        increment += (scaleFactor - 1) * static_cast<uint32_t>(last - first);
+    /**
+     * \brief Calcula la suma de las distancias entre todos los pares de galaxias.
+     * \param scaleFactor cuántas líneas ocupa cada línea vacía tras la expansión.
+     */
+    [[nodiscard]] UInt128 TotalDistance(const uint64_t scaleFactor) const noexcept
+    {
+        assert(scaleFactor >= 1);
+        return m_base + static_cast<UInt128>(scaleFactor - 1) * m_crossings;
     }
+};
 
-    return maxX - minX + maxY - minY + increment;
-}
-
-static uint32_t First(
-    const std::vector<Coord>& galaxies,
-    const std::vector<uint8_t>& emptyRows,
-    const std::vector<uint8_t>& emptyColumns
-)
+/**
+ * \brief Convierte un entero de 128 bits en texto.
+ */
+std::string ToString(UInt128 value)
 {
-    uint32_t res = 0;
-    for (size_t i = 0; i < galaxies.size() - 1; i++) {
-        for (size_t j = i + 1; j < galaxies.size(); j++) {
-            res += GetDistance(galaxies[i], galaxies[j], emptyRows, emptyColumns, 2);
-        }
+    std::string res;
+    do
+    {
+        res += static_cast<char>('0' + static_cast<uint32_t>(value % 10));
+        value /= 10;
     }
+    while (value != 0);
 
+    std::ranges::reverse(res);
     return res;
 }
 
-static uint64_t Second(
-    const std::vector<Coord>& galaxies,
-    const std::vector<uint8_t>& emptyRows,
-    const std::vector<uint8_t>& emptyColumns
-)
+static UInt128 First(const DistanceModel& model)
 {
-    uint64_t res = 0;
-    for (size_t i = 0; i < galaxies.size() - 1; i++) {
-        for (size_t j = i + 1; j < galaxies.size(); j++) {
-            res += GetDistance(galaxies[i], galaxies[j], emptyRows, emptyColumns, 1000000);
-        }
-    }
+    return model.TotalDistance(2);
+}
 
-    return res;
+static UInt128 Second(const DistanceModel& model)
+{
+    return model.TotalDistance(1000000);
 }
 
 int main()
@@ -81,36 +113,36 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    std::vector<Coord> galaxies;
-    std::vector<uint8_t> emptyRows;
-    std::vector<uint8_t> emptyColumns;
+    GalaxyCounts counts;
 
     {
         std::ifstream input("input", std::ios::binary);
 
-        std::set<uint8_t> usedColumns;
-        for (uint8_t j = 0; j < MAP_LENGTH; j++) {
-            bool rowIsEmpty = true;
-            for (uint8_t i = 0; i < MAP_LENGTH; i++) {
-                if (input.get() == '#') {
-                    galaxies.emplace_back(i, j);
-                    usedColumns.emplace(i);
-                    rowIsEmpty = false;
-                }
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            if (counts.columns.empty()) counts.columns.resize(line.size());
+            assert(line.size() == counts.columns.size());
+
+            uint64_t rowCount = 0;
+            for (size_t i = 0; i < line.size(); i++)
+            {
+                const bool galaxy = line[i] == '#';
+                counts.columns[i] += galaxy;
+                rowCount += galaxy;
             }
 
-            if (rowIsEmpty) emptyRows.emplace_back(j);
-            input.ignore();
-        }
-
-        for (uint8_t i = 0; i < MAP_LENGTH; i++) {
-            if (!usedColumns.contains(i))
-                emptyColumns.emplace_back(i);
+            counts.rows.push_back(rowCount);
         }
     }
 
-    std::cout << "Primera parte: " << First(galaxies, emptyRows, emptyColumns) << std::endl;
-    std::cout << "Segunda parte: " << Second(galaxies, emptyRows, emptyColumns) << std::endl;
+    const DistanceModel model(counts);
+
+    std::cout << "Primera parte: " << ToString(First(model)) << std::endl;
+    std::cout << "Segunda parte: " << ToString(Second(model)) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
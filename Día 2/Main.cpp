@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <span>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -112,13 +113,89 @@ public:
     }
 };
 
-uint32_t First(const std::vector<Game>& games)
+struct BagLimit
 {
-    uint32_t acc = 0;
-    for (const auto& game : games)
-        if (game.IsValid(12, 13, 14)) acc += game.GameId();
+    uint8_t maxRed;
+    uint8_t maxGreen;
+    uint8_t maxBlue;
+};
 
-    return acc;
+/*
+ * Una partida es válida para unos límites si y sólo si los máximos de cada color de la
+ * partida no los superan. Por tanto, basta con guardar la suma de identificadores en un
+ * cubo indexado por los máximos de cada partida y calcular sus sumas prefijas en las tres
+ * dimensiones. Cada consulta se convierte entonces en una única lectura del cubo.
+ *
+ * Las dimensiones del cubo se ajustan a los máximos observados en las partidas, por lo que
+ * los límites superiores a estos se recortan sin cambiar el resultado.
+ */
+class BagLimitIndex
+{
+    uint32_t redSize = 1;
+    uint32_t greenSize = 1;
+    uint32_t blueSize = 1;
+    std::vector<uint32_t> prefixSums;
+
+    [[nodiscard]] size_t Index(uint32_t red, uint32_t green, uint32_t blue) const noexcept
+    {
+        return (static_cast<size_t>(red) * greenSize + green) * blueSize + blue;
+    }
+
+public:
+    explicit BagLimitIndex(const std::vector<Game>& games)
+    {
+        for (const auto& game : games)
+        {
+            redSize = std::max(redSize, game.MaxRed() + 1);
+            greenSize = std::max(greenSize, game.MaxGreen() + 1);
+            blueSize = std::max(blueSize, game.MaxBlue() + 1);
+        }
+
+        prefixSums.resize(static_cast<size_t>(redSize) * greenSize * blueSize);
+        for (const auto& game : games)
+            prefixSums[Index(game.MaxRed(), game.MaxGreen(), game.MaxBlue())] += game.GameId();
+
+        // Acumulamos a lo largo de cada eje por separado. Tras las tres pasadas, cada
+        // celda contiene la suma de todas las celdas que domina.
+        for (uint32_t r = 0; r < redSize; r++)
+            for (uint32_t g = 0; g < greenSize; g++)
+                for (uint32_t b = 1; b < blueSize; b++)
+                    prefixSums[Index(r, g, b)] += prefixSums[Index(r, g, b - 1)];
+
+        for (uint32_t r = 0; r < redSize; r++)
+            for (uint32_t g = 1; g < greenSize; g++)
+                for (uint32_t b = 0; b < blueSize; b++)
+                    prefixSums[Index(r, g, b)] += prefixSums[Index(r, g - 1, b)];
+
+        for (uint32_t r = 1; r < redSize; r++)
+            for (uint32_t g = 0; g < greenSize; g++)
+                for (uint32_t b = 0; b < blueSize; b++)
+                    prefixSums[Index(r, g, b)] += prefixSums[Index(r - 1, g, b)];
+    }
+
+    [[nodiscard]] uint32_t Query(const BagLimit& limit) const noexcept
+    {
+        return prefixSums[Index(
+            std::min<uint32_t>(limit.maxRed, redSize - 1),
+            std::min<uint32_t>(limit.maxGreen, greenSize - 1),
+            std::min<uint32_t>(limit.maxBlue, blueSize - 1)
+        )];
+    }
+
+    [[nodiscard]] std::vector<uint32_t> Query(std::span<const BagLimit> limits) const
+    {
+        std::vector<uint32_t> results;
+        results.reserve(limits.size());
+        for (const auto& limit : limits)
+            results.emplace_back(Query(limit));
+
+        return results;
+    }
+};
+
+uint32_t First(const BagLimitIndex& index)
+{
+    return index.Query({ 12, 13, 14 });
 }
 
 uint32_t Second(const std::vector<Game>& games)
@@ -146,7 +223,9 @@ int main()
         input >> std::ws;
     }
 
-    std::cout << "Parte 1: " << First(games) << std::endl;
+    const BagLimitIndex index(games);
+
+    std::cout << "Parte 1: " << First(index) << std::endl;
     std::cout << "Parte 1: " << Second(games) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
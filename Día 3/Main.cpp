@@ -1,62 +1,250 @@
 #include <array>
-#include <unordered_map>
+#include <vector>
+#include <span>
+#include <bit>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <optional>
 #include <chrono>
 #include <iostream>
 #include <fstream>
-#include <ranges>
 
 
 #pragma region Global
 namespace
 {
     /*
-     * El tamaño de el mapa de las piezas es de 140x140. Esto nos permite
-     * copiar las líneas directamente a la memoria y con una sola lectura
-     * por línea.
+     * El tamaño de el mapa de las piezas se detecta al leerlo. El ancho es el de la
+     * primera línea, y todas las filas se guardan seguidas en un único vector, lo
+     * que nos permite copiar las líneas directamente a la memoria.
      */
 
-    constexpr int32_t DIM = 140;
-    std::array<std::array<unsigned char, DIM>, DIM> g_engineMap;
+    size_t g_width = 0;
+    size_t g_height = 0;
+    std::vector<unsigned char> g_engineMap;
+
+    /*
+     * Si se activa, el mapa no se carga entero en memoria, sino que se procesa fila a
+     * fila con «SchematicStream», que sólo guarda las últimas tres filas leídas.
+     */
+
+    constexpr bool STREAMING_MODE = false;
+}
+
+/**
+ * \brief Devuelve la fila indicada del mapa.
+ * \param i el índice de la fila.
+ */
+inline std::span<const unsigned char> EngineRow(const size_t i) noexcept
+{
+    return { g_engineMap.data() + i * g_width, g_width };
+}
+
+
+/*
+ * Cada fila del mapa se representa también como tres máscaras de bits: una con los dígitos,
+ * otra con los símbolos y otra con los engranajes. La columna «j» corresponde al bit «j % 64»
+ * de la palabra «j / 64». Los bits posteriores al ancho de la fila siempre valen cero, por lo
+ * que no hace falta comprobar los límites al operar con palabras enteras.
+ */
+
+typedef std::span<const uint64_t> RowMask;
+
+constexpr size_t WORD_BITS = 64;
+
+constexpr size_t WordCount(const size_t width) noexcept
+{
+    return (width + WORD_BITS - 1) / WORD_BITS;
+}
+
+struct SchematicMasks
+{
+    size_t words = 0;
+    size_t rows = 0;
+
+    std::vector<uint64_t> digits;
+    std::vector<uint64_t> symbols;
+    std::vector<uint64_t> gears;
+
+    [[nodiscard]] RowMask Digits(const size_t i) const noexcept { return { digits.data() + i * words, words }; }
+    [[nodiscard]] RowMask Symbols(const size_t i) const noexcept { return { symbols.data() + i * words, words }; }
+    [[nodiscard]] RowMask Gears(const size_t i) const noexcept { return { gears.data() + i * words, words }; }
+};
+
+namespace
+{
+    SchematicMasks g_masks;
 }
 
+/**
+ * \brief Activa en las máscaras los bits de una fila del mapa.
+ * \param row la fila del mapa.
+ * \param digits la máscara de dígitos de la fila.
+ * \param symbols la máscara de símbolos de la fila.
+ * \param gears la máscara de engranajes de la fila.
+ */
+inline void FillRowMasks(
+    const std::span<const unsigned char> row,
+    const std::span<uint64_t> digits,
+    const std::span<uint64_t> symbols,
+    const std::span<uint64_t> gears
+)
+{
+    for (size_t j = 0; j < row.size(); j++)
+    {
+        const unsigned char c = row[j];
+        const uint64_t bit = static_cast<uint64_t>(1) << (j % WORD_BITS);
+
+        if (std::isdigit(c))
+        {
+            digits[j / WORD_BITS] |= bit;
+        }
+        else if (c != '.')
+        {
+            symbols[j / WORD_BITS] |= bit;
+            if (c == '*') gears[j / WORD_BITS] |= bit;
+        }
+    }
+}
 
 /**
- * \brief Devuelve el elemento en dichas coordenadas, o un punto si
- * no está en el rango.
- * \param i la primera componente de la coordenada.
- * \param j la segunda componente de la coordenada.
+ * \brief Construye las máscaras de todas las filas de «g_engineMap».
  */
-inline unsigned char GetElementOrDot(const int32_t i, const int32_t j)
+inline void BuildMasks()
 {
-    if (i < 0 || i >= DIM || j < 0 || j >= DIM) return '.';
-    return g_engineMap[i][j];
+    g_masks.words = WordCount(g_width);
+    g_masks.rows = g_height;
+
+    g_masks.digits.assign(g_masks.words * g_height, 0);
+    g_masks.symbols.assign(g_masks.words * g_height, 0);
+    g_masks.gears.assign(g_masks.words * g_height, 0);
+
+    for (size_t i = 0; i < g_height; i++)
+    {
+        const size_t offset = i * g_masks.words;
+        FillRowMasks(
+            EngineRow(i),
+            { g_masks.digits.data() + offset, g_masks.words },
+            { g_masks.symbols.data() + offset, g_masks.words },
+            { g_masks.gears.data() + offset, g_masks.words }
+        );
+    }
 }
 
 /**
- * \brief Devuelve si el elemento en dichas coordenadas es un engranaje,
- * representado mediante un asterisco. 
- * \param i la primera componente de la coordenada.
- * \param j la segunda componente de la coordenada.
- * \return verdadero si es un engranaje y falso si no lo es o está
- * fuera de rango.
+ * \brief Acumula en «dst» la dilatación horizontal de «src», es decir, cada
+ * bit activo de la fila junto a sus vecinos izquierdo y derecho.
+ * \param src la máscara original.
+ * \param dst la máscara donde se acumula el resultado.
  */
-inline bool IsSymbol(const int32_t i, const int32_t j)
+inline void DilateRowInto(const RowMask src, const std::span<uint64_t> dst) noexcept
 {
-    const auto c = GetElementOrDot(i, j);
-    return c != '.' && !std::isdigit(c);
+    for (size_t w = 0; w < src.size(); w++)
+    {
+        const uint64_t carryLeft = w > 0 ? src[w - 1] >> (WORD_BITS - 1) : 0;
+        const uint64_t carryRight = w + 1 < src.size() ? src[w + 1] << (WORD_BITS - 1) : 0;
+
+        dst[w] |= src[w] | src[w] << 1 | carryLeft | src[w] >> 1 | carryRight;
+    }
 }
 
 /**
- * \brief Devuelve si el elemento en dichas coordenadas es un símbolo.
- * Los números y puntos no se consideran símbolos.
- * \param i la primera componente de la coordenada.
- * \param j la segunda componente de la coordenada.
- * \return verdadero si es un símbolo y falso si no lo es o está
- * fuera de rango.
+ * \brief Calcula la vecindad 3x3 de una máscara en la fila indicada, combinando
+ * las dilataciones horizontales de la fila anterior, la actual y la siguiente.
+ * \param rowAt función que devuelve la máscara de una fila.
+ * \param i la fila central.
+ * \param rows el número de filas.
+ * \param dst la máscara donde se escribe el resultado.
  */
-inline bool IsGear(const int32_t i, const int32_t j)
+template<typename RowAt>
+void NeighbourhoodInto(RowAt&& rowAt, const size_t i, const size_t rows, const std::span<uint64_t> dst) noexcept
 {
-    return GetElementOrDot(i, j) == '*';
+    std::ranges::fill(dst, 0);
+    if (i > 0) DilateRowInto(rowAt(i - 1), dst);
+    DilateRowInto(rowAt(i), dst);
+    if (i + 1 < rows) DilateRowInto(rowAt(i + 1), dst);
+}
+
+/**
+ * \brief Busca el siguiente bit con el valor indicado a partir de una posición.
+ * \param mask la máscara de la fila.
+ * \param pos la primera posición a comprobar.
+ * \param value el valor del bit buscado.
+ * \return la posición del bit o el número de bits de la máscara si no hay ninguno.
+ */
+inline size_t NextBit(const RowMask mask, const size_t pos, const bool value) noexcept
+{
+    const size_t bits = mask.size() * WORD_BITS;
+    if (pos >= bits) return bits;
+
+    size_t w = pos / WORD_BITS;
+    uint64_t word = (value ? mask[w] : ~mask[w]) & (~static_cast<uint64_t>(0) << (pos % WORD_BITS));
+
+    while (word == 0)
+    {
+        if (++w == mask.size()) return bits;
+        word = value ? mask[w] : ~mask[w];
+    }
+
+    return w * WORD_BITS + std::countr_zero(word);
+}
+
+/**
+ * \brief Devuelve la palabra «w» de una máscara con los bits en [first, last) activos.
+ */
+inline uint64_t RangeWordMask(const size_t w, const size_t first, const size_t last) noexcept
+{
+    const size_t wordStart = w * WORD_BITS;
+    const size_t lo = std::max(first, wordStart) - wordStart;
+    const size_t hi = std::min(last, wordStart + WORD_BITS) - wordStart;
+
+    const uint64_t upper = hi == WORD_BITS ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << hi) - 1;
+    return upper & (~static_cast<uint64_t>(0) << lo);
+}
+
+/**
+ * \brief Comprueba si hay algún bit activo en el rango [first, last).
+ */
+inline bool AnyInRange(const RowMask mask, const size_t first, const size_t last) noexcept
+{
+    if (first >= last) return false;
+
+    for (size_t w = first / WORD_BITS; w <= (last - 1) / WORD_BITS && w < mask.size(); w++)
+        if (mask[w] & RangeWordMask(w, first, last)) return true;
+
+    return false;
+}
+
+/**
+ * \brief Llama a «f» con la posición de cada bit activo en el rango [first, last).
+ */
+template<typename F>
+void ForEachInRange(const RowMask mask, const size_t first, const size_t last, F&& f)
+{
+    if (first >= last) return;
+
+    for (size_t w = first / WORD_BITS; w <= (last - 1) / WORD_BITS && w < mask.size(); w++)
+    {
+        uint64_t word = mask[w] & RangeWordMask(w, first, last);
+        while (word)
+        {
+            f(w * WORD_BITS + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+/**
+ * \brief Lee el número que ocupa las columnas [first, last) de una fila.
+ */
+inline uint32_t ParseNumber(const std::span<const unsigned char> row, const size_t first, const size_t last) noexcept
+{
+    uint32_t acc = 0;
+    for (size_t j = first; j < last; j++)
+        acc = acc * 10 + row[j] - '0';
+
+    return acc;
 }
 #pragma endregion
 
@@ -69,73 +257,32 @@ inline bool IsGear(const int32_t i, const int32_t j)
  * hay algún símbolo con el que esté en contacto.
  *
  * He elegido la segunda opción, ya que evita tener que mirar delante y detrás del número.
- * En vez de eso, sólo hace falta comprobar si está en contacto con algún símbolo y, si es
- * así, simplemente leer el número entero. También evita contar dos veces el mismo número.
+ * Con las máscaras de bits, la vecindad de los símbolos de una fila se obtiene dilatando
+ * las máscaras de las tres filas que la rodean. Cada número es una secuencia de bits
+ * consecutivos en la máscara de dígitos, y es una pieza si esa secuencia tiene algún bit
+ * en común con la vecindad. Así tampoco se cuenta dos veces el mismo número.
  */
 
-uint32_t First()
+uint64_t First()
 {
-    uint32_t res = 0;
+    uint64_t res = 0;
+    std::vector<uint64_t> nearSymbol(g_masks.words);
 
-    for (int32_t i = 0; i < DIM; i++)
+    for (size_t i = 0; i < g_masks.rows; i++)
     {
-        for (int32_t j = 0; j < DIM; j++)
+        NeighbourhoodInto([](const size_t k) { return g_masks.Symbols(k); }, i, g_masks.rows, nearSymbol);
+        const RowMask digits = g_masks.Digits(i);
+
+        // Recorremos las secuencias de dígitos de la fila.
+        for (size_t j = NextBit(digits, 0, true); j < g_width; )
         {
-            // Si no es el inicio de un número, nos lo saltamos
-            if (!std::isdigit(g_engineMap[i][j])) continue;
+            const size_t end = std::min(NextBit(digits, j, false), g_width);
 
-            bool isTouching = false;
-            uint32_t acc = 0;
+            // Si un número está en contacto con un símbolo, acumulamos su valor
+            if (AnyInRange(nearSymbol, j, end))
+                res += ParseNumber(EngineRow(i), j, end);
 
-            // Lee hasta el final del número, estableciendo j al final de este.
-            const auto completeNumber = [&]
-            {
-                // Evitamos realizar una primera comprobación, ya que el elemento
-                // actual ha de ser un dígito para llamar a completeNumber.
-                do
-                {
-                    acc = acc * 10 + g_engineMap[i][j] - '0';
-                    j++;
-                }
-                while (j < DIM && std::isdigit(g_engineMap[i][j]));
-            };
-
-            // Si un número está en contacto con un símbolo por la izquierda, leemos el número
-            // entero y lo aumentamos, ya que cumple el requisito.
-            if (IsSymbol(i - 1, j - 1) || IsSymbol(i, j - 1) || IsSymbol(i + 1, j - 1))
-            {
-                completeNumber();
-                isTouching = true;
-            }
-            else
-            {
-                // Mientras que el elemento sea un dígito y no se salga del rango,
-                // vamos buscando si está en contacto con un símbolo arriba o debajo.
-                do
-                {
-                    if (IsSymbol(i - 1, j) || IsSymbol(i + 1, j))
-                    {
-                        // Si está en contacto con un símbolo, completamos el número
-                        // y terminamos la búsqueda.
-                        completeNumber();
-                        isTouching = true;
-                        break;
-                    }
-
-                    // Vamos aumentando el valor acumulado mientras buscamos un símbolo.
-                    acc = acc * 10 + g_engineMap[i][j] - '0';
-                    j++;
-                }
-                while (j < DIM && std::isdigit(g_engineMap[i][j]));
-
-                // Si no se ha encontrado un símbolo aún, comprobamos el lado derecho.
-                if (!isTouching && (IsSymbol(i - 1, j) || IsSymbol(i, j) || IsSymbol(i + 1, j)))
-                    isTouching = true;
-            }
-
-            // Si el número está en contacto con un símbolo, acumulamos su valor
-            if (isTouching)
-                res += acc;
+            j = NextBit(digits, end, true);
         }
     }
 
@@ -148,12 +295,17 @@ uint32_t First()
 // ---------------------------------------- PARTE 2 ---------------------------------------- //
 /*
  * Mi solución a la parte 2 es muy similar a la parte 1, aunque algo distinta. Primero creo
- * un mapa donde almacenar los engranajes y los números con los que está en contacto. Luego
+ * una tabla donde almacenar los engranajes y los números con los que está en contacto. Luego
  * es sólo cuestión de comprobar qué engranajes están en contacto con exactamente dos números
  * y acumular el producto de estos. Un engranaje sólo necesita dos campos, uno para cada
  * número. El valor de un campo no asignado se establece en -1, y si se intenta añadir otro
  * número a un engranaje que tiene ya 2 asignados, uno de los valores se establece en cero,
  * ya que a la hora de acumular los productos, no participa al ser su producto nulo.
+ *
+ * En vez de identificar cada engranaje por sus coordenadas en un mapa hash, les asignamos
+ * índices consecutivos en el orden en el que aparecen. El índice de un engranaje es la
+ * cantidad de engranajes en las palabras anteriores de la máscara más los bits activos por
+ * debajo de él en su propia palabra, por lo que basta con precalcular la primera parte.
  */
 
 namespace
@@ -163,71 +315,83 @@ namespace
         int32_t first = -1;
         int32_t second = -1;
     };
-    std::unordered_map<int64_t, GearRatioNumbers> g_gearNumbers;
+
+    std::vector<uint32_t> g_gearWordOffsets;
+    std::vector<GearRatioNumbers> g_gearNumbers;
 }
 
-uint32_t Second()
+/**
+ * \brief Asigna un índice a cada engranaje y crea la tabla de números de los engranajes.
+ */
+inline void BuildGearTable()
 {
-    for (int32_t i = 0; i < DIM; i++)
-    {
-        for (int32_t j = 0; j < DIM; j++)
-        {
-            // Si no es el inicio de un número, nos lo saltamos
-            if (!std::isdigit(GetElementOrDot(i, j))) continue;
+    g_gearWordOffsets.resize(g_masks.gears.size());
 
-            // Los elementos son siempre únicos, ya que cada coordenada se comprueba
-            // una única vez por número.
-            std::vector<int64_t> gearKeys;
+    uint32_t gearCount = 0;
+    for (size_t w = 0; w < g_masks.gears.size(); w++)
+    {
+        g_gearWordOffsets[w] = gearCount;
+        gearCount += std::popcount(g_masks.gears[w]);
+    }
 
-            // Si el elemento es un engranaje, lo añade a la lista de engranajes.
-            const auto addIfGear = [&](const int32_t x, const int32_t y)
-            {
-                // El identificador de un engranaje son sus coordenadas, que son únicas.
-                if (IsGear(x, y))
-                    gearKeys.emplace_back(static_cast<int64_t>(x) << 32 | static_cast<int64_t>(y));
-            };
+    g_gearNumbers.assign(gearCount, {});
+}
 
-            // Comprobamos el lado izquierdo.
+/**
+ * \brief Devuelve el índice del engranaje en dichas coordenadas.
+ * \param i la fila del engranaje.
+ * \param j la columna del engranaje.
+ */
+inline uint32_t GearIndex(const size_t i, const size_t j) noexcept
+{
+    const size_t w = i * g_masks.words + j / WORD_BITS;
+    const uint64_t below = (static_cast<uint64_t>(1) << (j % WORD_BITS)) - 1;
 
-            addIfGear(i - 1, j - 1);
-            addIfGear(i, j - 1);
-            addIfGear(i + 1, j - 1);
+    return g_gearWordOffsets[w] + std::popcount(g_masks.gears[w] & below);
+}
 
-            uint32_t acc = 0;
-            for (; j < DIM && std::isdigit(g_engineMap[i][j]); j++)
-            {
-                // Mientras acumulamos el valor del número, comprobamos
-                // si hay engranajes arriba o debajo de la cifra actual.
-                addIfGear(i - 1, j);
-                addIfGear(i + 1, j);
+uint64_t Second()
+{
+    BuildGearTable();
 
-                acc = acc * 10 + g_engineMap[i][j] - '0';
-            }
+    for (size_t i = 0; i < g_masks.rows; i++)
+    {
+        const RowMask digits = g_masks.Digits(i);
 
-            // Comprobamos el lado derecho.
+        // Recorremos las secuencias de dígitos de la fila.
+        for (size_t j = NextBit(digits, 0, true); j < g_width; )
+        {
+            const size_t end = std::min(NextBit(digits, j, false), g_width);
+            const uint32_t acc = ParseNumber(EngineRow(i), j, end);
 
-            addIfGear(i - 1, j);
-            addIfGear(i, j);
-            addIfGear(i + 1, j);
+            // Añadimos el valor del número a los engranajes de las tres filas que lo rodean,
+            // desde la columna anterior a su inicio hasta la columna posterior a su final.
+            // Cada engranaje aparece una única vez por número.
+            const size_t firstColumn = j > 0 ? j - 1 : 0;
+            const size_t lastColumn = end + 1;
 
-            // Añadimos el valor del número al engranaje.
-            for (auto& gearKey : gearKeys)
+            for (size_t x = i > 0 ? i - 1 : 0; x <= i + 1 && x < g_masks.rows; x++)
             {
-                auto& [first, second] = g_gearNumbers[gearKey];
-
-                if (first == -1) // Ningún adyacente
-                    first = static_cast<int32_t>(acc);
-                else if (second == -1) // Sólo un adyacente
-                    second = static_cast<int32_t>(acc);
-                else // Más de dos adyacentes
-                    first = 0;
+                ForEachInRange(g_masks.Gears(x), firstColumn, lastColumn, [&](const size_t y)
+                {
+                    auto& [first, second] = g_gearNumbers[GearIndex(x, y)];
+
+                    if (first == -1) // Ningún adyacente
+                        first = static_cast<int32_t>(acc);
+                    else if (second == -1) // Sólo un adyacente
+                        second = static_cast<int32_t>(acc);
+                    else // Más de dos adyacentes
+                        first = 0;
+                });
             }
+
+            j = NextBit(digits, end, true);
         }
     }
 
     // Acumulamos el producto de los engranajes.
-    uint32_t res = 0;
-    for (const auto [first, second] : g_gearNumbers | std::views::values)
+    uint64_t res = 0;
+    for (const auto [first, second] : g_gearNumbers)
     {
         // Si no están ambos asignados, está en contacto con menos de
         // dos números y nos saltamos el engranaje.
@@ -236,7 +400,7 @@ uint32_t Second()
         // Agregamos el valor del producto. Si uno de los engranajes
         // está en contacto con más de dos números, el producto es cero,
         // por lo que no afecta al resultado.
-        res += first * second;
+        res += static_cast<uint64_t>(first) * static_cast<uint64_t>(second);
     }
 
     return res;
@@ -244,6 +408,156 @@ uint32_t Second()
 #pragma endregion
 
 
+#pragma region Streaming
+// --------------------------------------- STREAMING --------------------------------------- //
+/*
+ * Ambas partes sólo necesitan conocer las filas vecinas de cada número, por lo que se pueden
+ * resolver a la vez guardando una ventana con las tres últimas filas. Cuando llega una fila,
+ * la anterior ya tiene sus dos vecinas y podemos evaluar sus números. En ese momento, los
+ * engranajes de la fila previa a esa ya han recibido todos sus números, así que acumulamos
+ * sus productos y su hueco en la ventana queda libre para la siguiente fila.
+ *
+ * Los engranajes de cada fila de la ventana se guardan en una tabla densa indexada por la
+ * columna, por lo que la memoria necesaria sólo depende del ancho del mapa.
+ */
+
+class SchematicStream
+{
+    static constexpr size_t WINDOW = 3;
+
+    size_t m_width;
+    size_t m_words;
+    size_t m_rows = 0;
+
+    std::array<std::vector<unsigned char>, WINDOW> m_text;
+    std::array<std::vector<uint64_t>, WINDOW> m_digits;
+    std::array<std::vector<uint64_t>, WINDOW> m_symbols;
+    std::array<std::vector<uint64_t>, WINDOW> m_gears;
+    std::array<std::vector<GearRatioNumbers>, WINDOW> m_gearNumbers;
+
+    std::vector<uint64_t> m_nearSymbol;
+
+    uint64_t m_partNumbers = 0;
+    uint64_t m_gearRatios = 0;
+
+    static size_t Slot(const size_t i) noexcept { return i % WINDOW; }
+
+    /**
+     * \brief Acumula los números de la fila indicada. Sus filas vecinas han de
+     * estar en la ventana.
+     * \param i el índice de la fila.
+     */
+    void EvaluateRow(const size_t i)
+    {
+        const auto symbolsAt = [this](const size_t k) { return RowMask(m_symbols[Slot(k)]); };
+        NeighbourhoodInto(symbolsAt, i, m_rows, m_nearSymbol);
+
+        const RowMask digits = m_digits[Slot(i)];
+        const std::span<const unsigned char> text = m_text[Slot(i)];
+
+        for (size_t j = NextBit(digits, 0, true); j < m_width; )
+        {
+            const size_t end = std::min(NextBit(digits, j, false), m_width);
+            const uint32_t acc = ParseNumber(text, j, end);
+
+            if (AnyInRange(m_nearSymbol, j, end))
+                m_partNumbers += acc;
+
+            const size_t firstColumn = j > 0 ? j - 1 : 0;
+            const size_t lastColumn = end + 1;
+
+            for (size_t x = i > 0 ? i - 1 : 0; x <= i + 1 && x < m_rows; x++)
+            {
+                auto& gearNumbers = m_gearNumbers[Slot(x)];
+                ForEachInRange(m_gears[Slot(x)], firstColumn, lastColumn, [&](const size_t y)
+                {
+                    auto& [first, second] = gearNumbers[y];
+
+                    if (first == -1) // Ningún adyacente
+                        first = static_cast<int32_t>(acc);
+                    else if (second == -1) // Sólo un adyacente
+                        second = static_cast<int32_t>(acc);
+                    else // Más de dos adyacentes
+                        first = 0;
+                });
+            }
+
+            j = NextBit(digits, end, true);
+        }
+    }
+
+    /**
+     * \brief Acumula los productos de los engranajes de la fila indicada, que ya
+     * han de tener todos sus números asignados.
+     * \param i el índice de la fila.
+     */
+    void FinishGears(const size_t i)
+    {
+        const auto& gearNumbers = m_gearNumbers[Slot(i)];
+        ForEachInRange(m_gears[Slot(i)], 0, m_width, [&](const size_t y)
+        {
+            const auto [first, second] = gearNumbers[y];
+            if (first >= 0 && second >= 0)
+                m_gearRatios += static_cast<uint64_t>(first) * static_cast<uint64_t>(second);
+        });
+    }
+
+public:
+    explicit SchematicStream(const size_t width)
+        : m_width(width), m_words(WordCount(width)), m_nearSymbol(WordCount(width))
+    {
+        for (size_t k = 0; k < WINDOW; k++)
+        {
+            m_text[k].resize(m_width);
+            m_digits[k].resize(m_words);
+            m_symbols[k].resize(m_words);
+            m_gears[k].resize(m_words);
+            m_gearNumbers[k].resize(m_width);
+        }
+    }
+
+    /**
+     * \brief Añade una fila al final del mapa. Las filas más cortas que el ancho
+     * se completan con puntos y las más largas se recortan.
+     * \param row la fila a añadir.
+     */
+    void PushRow(const std::string_view row)
+    {
+        const size_t slot = Slot(m_rows);
+
+        auto& text = m_text[slot];
+        const size_t copied = std::min(row.size(), m_width);
+        std::ranges::copy(row.substr(0, copied), text.begin());
+        std::fill(text.begin() + static_cast<ptrdiff_t>(copied), text.end(), '.');
+
+        std::ranges::fill(m_digits[slot], 0);
+        std::ranges::fill(m_symbols[slot], 0);
+        std::ranges::fill(m_gears[slot], 0);
+        std::ranges::fill(m_gearNumbers[slot], GearRatioNumbers{});
+        FillRowMasks(text, m_digits[slot], m_symbols[slot], m_gears[slot]);
+
+        m_rows++;
+        if (m_rows >= 2) EvaluateRow(m_rows - 2);
+        if (m_rows >= 3) FinishGears(m_rows - 3);
+    }
+
+    /**
+     * \brief Procesa las filas que quedan en la ventana tras la última fila.
+     */
+    void Finish()
+    {
+        if (m_rows >= 1) EvaluateRow(m_rows - 1);
+        if (m_rows >= 2) FinishGears(m_rows - 2);
+        if (m_rows >= 1) FinishGears(m_rows - 1);
+    }
+
+    [[nodiscard]] uint64_t PartNumbers() const noexcept { return m_partNumbers; }
+    [[nodiscard]] uint64_t GearRatios() const noexcept { return m_gearRatios; }
+};
+
+#pragma endregion
+
+
 #pragma region Ejecución
 // --------------------------------------- EJECUCIÓN --------------------------------------- //
 
@@ -255,18 +569,48 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
+    if constexpr (STREAMING_MODE)
     {
         std::ifstream input("input", std::ios::binary);
+        std::optional<SchematicStream> stream;
 
-        for (auto& row : g_engineMap)
+        std::string line;
+        while (std::getline(input, line))
         {
-            input.read(reinterpret_cast<char*>(row.data()), DIM);
-            input >> std::ws;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            if (!stream) stream.emplace(line.size());
+            stream->PushRow(line);
         }
+
+        if (stream) stream->Finish();
+
+        std::cout << "Primera parte: " << (stream ? stream->PartNumbers() : 0) << std::endl;
+        std::cout << "Segunda parte: " << (stream ? stream->GearRatios() : 0) << std::endl;
     }
+    else
+    {
+        std::ifstream input("input", std::ios::binary);
+
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
 
-    std::cout << "Primera parte: " << First() << std::endl;
-    std::cout << "Segunda parte: " << Second() << std::endl;
+            if (g_width == 0) g_width = line.size();
+            line.resize(g_width, '.');
+
+            g_engineMap.insert(g_engineMap.end(), line.begin(), line.end());
+            g_height++;
+        }
+
+        BuildMasks();
+
+        std::cout << "Primera parte: " << First() << std::endl;
+        std::cout << "Segunda parte: " << Second() << std::endl;
+    }
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::clog << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
@@ -1,4 +1,9 @@
-#include <unordered_set>
+#include <vector>
+#include <string>
+#include <bit>
+#include <algorithm>
+#include <optional>
+#include <cassert>
 #include <chrono>
 #include <iostream>
 #include <fstream>
@@ -10,18 +15,170 @@
  * La única información que necesitamos por boleto es la cantidad de veces que un número de
  * boleto ha resultado ganador y la cantidad de copias que tenemos de ese boleto (necesario
  * para la  parte 2, lo iniciamos a una copia). Además, todos los boletos tienen la misma
- * cantidad de posibles números ganadores y de números de boleto.
+ * cantidad de posibles números ganadores y de números de boleto, que obtenemos de la primera
+ * línea.
+ *
+ * Todos los números ocupan un campo de ancho fijo: un espacio seguido de las cifras, alineadas
+ * a la derecha y rellenas con espacios. Esto nos permite leerlos directamente de la línea y
+ * representar cada conjunto de números como una máscara de bits, de forma que la cantidad de
+ * aciertos es el número de bits activos en la intersección. Con números de dos cifras, cada
+ * máscara ocupa 128 bits.
  */
 
-constexpr size_t WINNING_NUMBER_COUNT = 10;
-constexpr size_t CARD_NUMBER_COUNT = 25;
+// Si se activa, los boletos se procesan a medida que se leen con «ScratchcardStream»,
+// sin guardarlos en memoria.
+constexpr bool STREAMING_MODE = false;
+
+struct CardGeometry
+{
+    size_t winningStart;
+    size_t winningCount;
+    size_t cardStart;
+    size_t cardCount;
+    size_t fieldWidth;
+
+    /**
+     * \brief Obtiene la forma de los boletos a partir de una línea de ejemplo.
+     * \param line la primera línea de la entrada.
+     */
+    explicit CardGeometry(const std::string& line)
+    {
+        const auto countNumbers = [&](const size_t first, const size_t last)
+        {
+            size_t count = 0;
+            for (size_t i = first; i < last; i++)
+                if (std::isdigit(line[i]) && !std::isdigit(line[i - 1])) count++;
+
+            return count;
+        };
+
+        const size_t colon = line.find(':');
+        const size_t separator = line.find('|');
+        if (colon == std::string::npos || separator == std::string::npos || separator < colon)
+            throw std::exception("El boleto no tiene el formato esperado");
+
+        size_t lineEnd = line.size();
+        while (lineEnd > 0 && !std::isdigit(line[lineEnd - 1])) lineEnd--;
+
+        winningStart = colon + 1;
+        cardStart = separator + 1;
+
+        winningCount = countNumbers(winningStart, separator);
+        cardCount = countNumbers(cardStart, lineEnd);
+        if (winningCount == 0 || cardCount == 0) throw std::exception("El boleto no tiene números");
+
+        // Cada campo de los números ganadores ocupa lo mismo, y tras el último hay
+        // un espacio antes de la barra.
+        fieldWidth = (separator - 1 - winningStart) / winningCount;
+    }
+
+    [[nodiscard]] uint32_t MaxNumber() const noexcept
+    {
+        uint32_t res = 1;
+        for (size_t i = 1; i < fieldWidth; i++) res *= 10;
+        return res;
+    }
+};
+
+class NumberMask
+{
+    std::vector<uint64_t> m_words;
+
+public:
+    explicit NumberMask(const uint32_t maxNumber) : m_words((maxNumber + 63) / 64) {}
+
+    void Clear() noexcept { std::ranges::fill(m_words, 0); }
+
+    void Set(const uint32_t number) noexcept
+    {
+        m_words[number / 64] |= static_cast<uint64_t>(1) << (number % 64);
+    }
+
+    [[nodiscard]] uint32_t CountCommon(const NumberMask& other) const noexcept
+    {
+        uint32_t count = 0;
+        for (size_t w = 0; w < m_words.size(); w++)
+            count += std::popcount(m_words[w] & other.m_words[w]);
+
+        return count;
+    }
+};
+
+/**
+ * \brief Lee una secuencia de números en campos de ancho fijo.
+ * \param line la línea del boleto.
+ * \param pos la posición del primer campo.
+ * \param count la cantidad de números a leer.
+ * \param fieldWidth el ancho de cada campo, incluyendo el espacio inicial.
+ * \param mask la máscara donde se activan los números leídos.
+ */
+inline void ParseNumbers(
+    const std::string& line,
+    const size_t pos,
+    const size_t count,
+    const size_t fieldWidth,
+    NumberMask& mask
+)
+{
+    mask.Clear();
+    for (size_t k = 0; k < count; k++)
+    {
+        uint32_t number = 0;
+        for (size_t i = pos + fieldWidth * k + 1; i < pos + fieldWidth * (k + 1); i++)
+            number = number * 10 + (line[i] == ' ' ? 0 : line[i] - '0');
+
+        mask.Set(number);
+    }
+}
+
+/**
+ * \brief Calcula los aciertos de cada línea de la entrada, reutilizando las
+ * máscaras entre boletos.
+ */
+class CardReader
+{
+    CardGeometry m_geometry;
+    NumberMask m_winningNumbers;
+    NumberMask m_cardNumbers;
+
+public:
+    explicit CardReader(const std::string& firstLine)
+        : m_geometry(firstLine),
+          m_winningNumbers(m_geometry.MaxNumber()),
+          m_cardNumbers(m_geometry.MaxNumber())
+    {}
+
+    [[nodiscard]] const CardGeometry& Geometry() const noexcept { return m_geometry; }
+
+    /**
+     * \brief Devuelve la cantidad de números del boleto que son ganadores.
+     * \param line la línea del boleto.
+     */
+    [[nodiscard]] uint32_t Matches(const std::string& line)
+    {
+        const auto& [winningStart, winningCount, cardStart, cardCount, fieldWidth] = m_geometry;
+        ParseNumbers(line, winningStart, winningCount, fieldWidth, m_winningNumbers);
+        ParseNumbers(line, cardStart, cardCount, fieldWidth, m_cardNumbers);
+
+        return m_winningNumbers.CountCommon(m_cardNumbers);
+    }
+};
 
 struct Card
 {
     uint32_t matches;
-    uint32_t repetitions = 1;
+    uint64_t repetitions = 1;
 };
 
+/**
+ * \brief Suma dos cantidades de copias, comprobando que el resultado cabe en 64 bits.
+ */
+[[nodiscard]] inline uint64_t AddCopies(const uint64_t a, const uint64_t b)
+{
+    if (a > UINT64_MAX - b) throw std::exception("Las copias no caben en 64 bits");
+    return a + b;
+}
+
 /**
  * \brief Crea un vector con los boletos del problema, calculando la
  * cantidad de números ganadores del boleto y el número de copias.
@@ -33,38 +190,36 @@ std::vector<Card> LoadCards()
 
     // Creamos el vector con los boletos y su puntuación.
     std::vector<Card> cards;
-    while (!input.eof())
+    std::string line;
+    std::optional<CardReader> reader;
+
+    while (std::getline(input, line))
     {
-        input.ignore(10);
-        std::unordered_set<uint32_t> winningNumbers;
-        for (size_t _ = 0; _ < WINNING_NUMBER_COUNT; _++)
-        {
-            uint32_t winningNumber;
-            input >> winningNumber >> std::ws;
-            winningNumbers.emplace(winningNumber);
-        }
+        if (line.empty() || line == "\r") continue;
+        if (!reader) reader.emplace(line);
 
         // Calculamos la cantidad de números del boleto que son ganadores.
-        uint32_t matches = 0;
-
-        input.ignore(2);
-        for (size_t _ = 0; _ < CARD_NUMBER_COUNT; _++)
-        {
-            uint32_t cardNumber;
-            input >> cardNumber >> std::ws;
-            if (winningNumbers.contains(cardNumber))
-                matches += 1;
-        }
-
-        cards.emplace_back(static_cast<uint8_t>(matches));
+        cards.emplace_back(reader->Matches(line));
     }
 
-    // Calculamos el número de copias de cada boleto.
+    // Calculamos el número de copias de cada boleto. Cada boleto suma sus copias a un rango
+    // de los boletos siguientes, así que en vez de recorrer ese rango llevamos la suma de las
+    // copias que se están repartiendo y guardamos en qué boleto deja de repartirse cada una.
+    // Los rangos que se salen de la lista de boletos se recortan. Todas las cantidades son
+    // positivas, así que podemos comprobar que ninguna suma desborda.
+    std::vector<uint64_t> expiring(cards.size() + 1);
+    uint64_t extraCopies = 0;
+
     for (size_t i = 0; i < cards.size(); i++)
     {
-        const auto& [matches, repetitions] = cards[i];
-        for (int32_t j = 0; j < static_cast<int32_t>(matches); j++)
-            cards[i + 1 + j].repetitions += repetitions;
+        auto& [matches, repetitions] = cards[i];
+
+        extraCopies -= expiring[i];
+        repetitions = AddCopies(repetitions, extraCopies);
+
+        extraCopies = AddCopies(extraCopies, repetitions);
+        uint64_t& expiry = expiring[std::min(i + 1 + matches, cards.size())];
+        expiry = AddCopies(expiry, repetitions);
     }
 
     return cards;
@@ -79,9 +234,9 @@ std::vector<Card> LoadCards()
  * La primera parte es trivial. Calculamos la puntuación de cada boleto y la acumulamos.
  */
 
-uint32_t First(const std::vector<Card>& cards)
+uint64_t First(const std::vector<Card>& cards)
 {
-    uint32_t res = 0;
+    uint64_t res = 0;
 
     // El primer número ganador vale un punto. Cada número ganador tras ese duplica la
     // puntuación. Duplicar en binario es equivalente a correr los bits a la izquierda.
@@ -89,7 +244,10 @@ uint32_t First(const std::vector<Card>& cards)
     // siendo «0» la posición inicial y «matches» la cantidad de números ganadores.
     // Si no hay números ganadores la puntuación es cero.
     for (const auto& [matches, _] : cards)
-        res += static_cast<uint32_t>(1) << (matches - 1);
+    {
+        if (matches > 64) throw std::exception("La puntuación no cabe en 64 bits");
+        if (matches > 0) res += static_cast<uint64_t>(1) << (matches - 1);
+    }
 
     return res;
 }
@@ -103,11 +261,11 @@ uint32_t First(const std::vector<Card>& cards)
  * La segunda parte también es trivial. Solamente tenemos que acumular el número de copias.
  */
 
-uint32_t Second(std::vector<Card>& cards)
+uint64_t Second(const std::vector<Card>& cards)
 {
-    uint32_t res = 0;
+    uint64_t res = 0;
     for (const auto& [_, repetitions] : cards)
-        res += repetitions;
+        res = AddCopies(res, repetitions);
 
     return res;
 }
@@ -115,6 +273,63 @@ uint32_t Second(std::vector<Card>& cards)
 #pragma endregion
 
 
+#pragma region Streaming
+// --------------------------------------- STREAMING --------------------------------------- //
+/*
+ * Un boleto sólo reparte copias a los «matches» boletos siguientes, y nunca puede tener más
+ * aciertos que números ganadores o números de boleto. Por tanto, las copias pendientes de
+ * dejar de repartirse de «LoadCards» caben en un búfer circular de ese tamaño (más el boleto
+ * actual y el final del rango), y podemos resolver ambas partes a medida que leemos los boletos
+ * sin guardarlos.
+ */
+
+class ScratchcardStream
+{
+    std::vector<uint64_t> m_expiring;
+    size_t m_index = 0;
+    uint64_t m_extraCopies = 0;
+
+    uint64_t m_points = 0;
+    uint64_t m_totalCards = 0;
+
+public:
+    explicit ScratchcardStream(const size_t maxMatches) : m_expiring(maxMatches + 2) {}
+
+    /**
+     * \brief Procesa el siguiente boleto.
+     * \param matches la cantidad de números ganadores del boleto.
+     */
+    void Push(const uint32_t matches)
+    {
+        assert(matches + 2 <= m_expiring.size());
+        const size_t size = m_expiring.size();
+
+        auto& expired = m_expiring[m_index % size];
+        m_extraCopies -= expired;
+        expired = 0;
+
+        const uint64_t repetitions = AddCopies(1, m_extraCopies);
+        m_totalCards = AddCopies(m_totalCards, repetitions);
+
+        if (matches > 64) throw std::exception("La puntuación no cabe en 64 bits");
+        if (matches > 0) m_points += static_cast<uint64_t>(1) << (matches - 1);
+
+        // Las copias que caen tras el último boleto nunca se leen, así que no hace falta
+        // recortar el rango.
+        m_extraCopies = AddCopies(m_extraCopies, repetitions);
+        uint64_t& expiry = m_expiring[(m_index + 1 + matches) % size];
+        expiry = AddCopies(expiry, repetitions);
+
+        m_index++;
+    }
+
+    [[nodiscard]] uint64_t Points() const noexcept { return m_points; }
+    [[nodiscard]] uint64_t TotalCards() const noexcept { return m_totalCards; }
+};
+
+#pragma endregion
+
+
 #pragma region Ejecución
 // --------------------------------------- EJECUCIÓN --------------------------------------- //
 
@@ -126,10 +341,37 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    auto cards = LoadCards();
+    if constexpr (STREAMING_MODE)
+    {
+        std::ifstream input("input", std::ios::binary);
+
+        std::string line;
+        std::optional<CardReader> reader;
+        std::optional<ScratchcardStream> stream;
+
+        while (std::getline(input, line))
+        {
+            if (line.empty() || line == "\r") continue;
+
+            if (!reader)
+            {
+                reader.emplace(line);
+                stream.emplace(std::min(reader->Geometry().winningCount, reader->Geometry().cardCount));
+            }
 
-    std::cout << "Primera parte: " << First(cards) << std::endl;
-    std::cout << "Segunda parte: " << Second(cards) << std::endl;
+            stream->Push(reader->Matches(line));
+        }
+
+        std::cout << "Primera parte: " << (stream ? stream->Points() : 0) << std::endl;
+        std::cout << "Segunda parte: " << (stream ? stream->TotalCards() : 0) << std::endl;
+    }
+    else
+    {
+        const auto cards = LoadCards();
+
+        std::cout << "Primera parte: " << First(cards) << std::endl;
+        std::cout << "Segunda parte: " << Second(cards) << std::endl;
+    }
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::clog << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
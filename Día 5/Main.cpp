@@ -7,25 +7,47 @@
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <limits>
+#include <span>
+#include <bit>
+#include <random>
+#include <numeric>
+#include <execution>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Si se activa, las siete tablas se componen en una única función de semilla a ubicación
+// antes de resolver ambas partes. Si no, cada semilla se traslada tabla a tabla.
+constexpr bool COMPOSE_MAPS = true;
+
+// Si se activa junto a «COMPOSE_MAPS», la segunda parte se resuelve recorriendo las ubicaciones
+// de menor a mayor y buscando sus semillas, en vez de trasladar los rangos de semillas.
+constexpr bool REVERSE_LOOKUP = false;
+
+// Si se activa, en vez de resolver la entrada se comparan los distintos métodos de búsqueda
+// sobre almanaques generados aleatoriamente.
+constexpr bool RUN_BENCHMARK = false;
 
 struct Node
 {
-    uint32_t toStart;
-    uint32_t fromStart;
-    uint32_t length;
+    uint64_t toStart;
+    uint64_t fromStart;
+    uint64_t length;
 
-    [[nodiscard]] bool IsBeforeOrEqual(const uint32_t a) const noexcept
+    [[nodiscard]] bool IsBeforeOrEqual(const uint64_t a) const noexcept
     {
         return fromStart <= a;
     }
 
-    [[nodiscard]] bool Contains(const uint32_t a) const noexcept
+    [[nodiscard]] bool Contains(const uint64_t a) const noexcept
     {
         assert(IsBeforeOrEqual(a));
         return a - fromStart < length;
     }
 
-    [[nodiscard]] uint32_t Translate(const uint32_t a) const noexcept
+    [[nodiscard]] uint64_t Translate(const uint64_t a) const noexcept
     {
         assert(Contains(a));
         return (a - fromStart) + toStart;
@@ -56,19 +78,165 @@ struct Range
 
 struct Almanac
 {
-    std::vector<uint32_t> seeds;
+    std::vector<uint64_t> seeds;
 
-    std::vector<Range<uint32_t>> seedRanges;
+    std::vector<Range<uint64_t>> seedRanges;
     std::array<std::set<Node>, 7> maps;
 };
 
-uint32_t First(const Almanac& almanac)
+/*
+ * Cada tabla es una función lineal a trozos: suma un desplazamiento distinto en cada uno de sus
+ * intervalos y deja igual el resto de valores. La composición de dos funciones así es también
+ * lineal a trozos, así que podemos componer las siete tablas en una única función que lleve
+ * cada semilla directamente a su ubicación.
+ *
+ * La función se guarda como una lista de trozos contiguos ordenados que cubren todo el dominio.
+ * Cada trozo empieza donde termina el anterior, por lo que basta con guardar su inicio y su
+ * desplazamiento. Los trozos consecutivos con el mismo desplazamiento se fusionan.
+ *
+ * El dominio termina en 2^62: así los desplazamientos caben en un entero de 64 bits con signo y
+ * las búsquedas vectoriales pueden comparar los valores como enteros con signo. Al leer la entrada
+ * se rechazan las semillas y los intervalos de las tablas que no terminan antes de ese límite.
+ */
+
+class PiecewiseMap
+{
+public:
+    static constexpr uint64_t DOMAIN_END = static_cast<uint64_t>(1) << 62;
+
+    struct Piece
+    {
+        uint64_t start;
+        int64_t offset;
+    };
+
+private:
+    std::vector<Piece> m_pieces;
+
+    [[nodiscard]] uint64_t End(const size_t i) const noexcept
+    {
+        return i + 1 < m_pieces.size() ? m_pieces[i + 1].start : DOMAIN_END;
+    }
+
+    void Append(const uint64_t start, const int64_t offset)
+    {
+        if (!m_pieces.empty() && m_pieces.back().offset == offset) return;
+        m_pieces.emplace_back(start, offset);
+    }
+
+public:
+    /**
+     * \brief Crea la función lineal a trozos de una tabla del almanaque.
+     * \param map los intervalos de la tabla, que no se solapan.
+     */
+    static PiecewiseMap FromNodes(const std::set<Node>& map)
+    {
+        PiecewiseMap res;
+        uint64_t cursor = 0;
+
+        for (const auto& node : map)
+        {
+            if (node.length == 0) continue;
+
+            if (node.fromStart > cursor) res.Append(cursor, 0);
+            res.Append(node.fromStart, static_cast<int64_t>(node.toStart) - static_cast<int64_t>(node.fromStart));
+            cursor = static_cast<uint64_t>(node.fromStart) + node.length;
+        }
+
+        if (cursor < DOMAIN_END) res.Append(cursor, 0);
+        return res;
+    }
+
+    /**
+     * \brief Compone esta función con la siguiente, aplicando primero esta.
+     * \param next la función a aplicar tras esta.
+     * \return La función compuesta.
+     */
+    [[nodiscard]] PiecewiseMap Then(const PiecewiseMap& next) const
+    {
+        PiecewiseMap res;
+
+        for (size_t i = 0; i < m_pieces.size(); i++)
+        {
+            const auto [start, offset] = m_pieces[i];
+
+            // Partimos la imagen del trozo según los trozos de la siguiente función.
+            uint64_t imageStart = start + offset;
+            const uint64_t imageEnd = End(i) + offset;
+
+            for (size_t j = next.Find(imageStart); imageStart < imageEnd; j++)
+            {
+                res.Append(imageStart - offset, offset + next.m_pieces[j].offset);
+                imageStart = std::min(imageEnd, next.End(j));
+            }
+        }
+
+        return res;
+    }
+
+    /**
+     * \brief Devuelve el índice del trozo que contiene el valor.
+     */
+    [[nodiscard]] size_t Find(const uint64_t x) const noexcept
+    {
+        assert(x < DOMAIN_END);
+        const auto it = std::ranges::upper_bound(m_pieces, x, {}, &Piece::start);
+        return static_cast<size_t>(it - m_pieces.begin()) - 1;
+    }
+
+    [[nodiscard]] uint64_t operator()(const uint64_t x) const noexcept
+    {
+        return x + m_pieces[Find(x)].offset;
+    }
+
+    /**
+     * \brief Calcula el menor valor de la función sobre un conjunto de rangos.
+     * Como cada trozo es creciente, su mínimo dentro de un rango está en su
+     * primer punto, así que basta con un barrido sobre los rangos ordenados.
+     * \param ranges los rangos de entrada, con longitud positiva.
+     */
+    [[nodiscard]] uint64_t MinOver(std::vector<Range<uint64_t>> ranges) const
+    {
+        std::sort(ranges.begin(), ranges.end());
+
+        uint64_t res = std::numeric_limits<uint64_t>::max();
+        size_t i = 0;
+
+        for (const auto& [start, length] : ranges)
+        {
+            const uint64_t end = start + length;
+            while (End(i) <= start) i++;
+
+            for (size_t j = i; j < m_pieces.size() && m_pieces[j].start < end; j++)
+                res = std::min(res, std::max(start, m_pieces[j].start) + m_pieces[j].offset);
+        }
+
+        return res;
+    }
+
+    [[nodiscard]] size_t Size() const noexcept { return m_pieces.size(); }
+    [[nodiscard]] std::span<const Piece> Pieces() const noexcept { return m_pieces; }
+};
+
+/**
+ * \brief Compone las siete tablas del almanaque en una única función.
+ */
+inline PiecewiseMap ComposeMaps(const Almanac& almanac)
 {
-    std::vector<uint32_t> setA(almanac.seeds);
-    std::vector<uint32_t> setB;
+    PiecewiseMap res = PiecewiseMap::FromNodes(almanac.maps.front());
+    for (size_t i = 1; i < almanac.maps.size(); i++)
+        res = res.Then(PiecewiseMap::FromNodes(almanac.maps[i]));
+
+    return res;
+}
 
-    std::vector<uint32_t>* from = &setA;
-    std::vector<uint32_t>* to = &setB;
+uint64_t First(const Almanac& almanac)
+{
+    std::vector<uint64_t> setA(almanac.seeds);
+    std::vector<uint64_t> setB;
+
+    std::vector<uint64_t>* from = &setA;
+    std::vector<uint64_t>* to = &setB;
 
     for (const auto& map : almanac.maps)
     {
@@ -117,7 +285,7 @@ uint32_t First(const Almanac& almanac)
             seed = !from->empty() ? std::make_optional(from->front()) : std::nullopt;
         }
 
-        std::vector<uint32_t>* tmp = from;
+        std::vector<uint64_t>* tmp = from;
         from = to;
         to = tmp;
     }
@@ -125,97 +293,422 @@ uint32_t First(const Almanac& almanac)
     return from->front();
 }
 
-uint32_t Second(const Almanac& almanac)
+/*
+ * Para la segunda parte trasladamos los rangos de semillas tabla a tabla. En cada etapa
+ * ordenamos los rangos, fusionamos los que se solapan y los barremos junto a los trozos de la
+ * tabla, que también están ordenados, partiendo cada rango por los límites de los trozos. Como
+ * los trozos cubren todo el dominio, no hay que distinguir los valores que no se trasladan.
+ *
+ * Los rangos ordenados se reparten en bloques independientes que se barren en paralelo. Cada
+ * bloque busca su primer trozo y escribe sus resultados en su propio vector.
+ */
+
+constexpr size_t RANGE_BLOCK_SIZE = 4096;
+
+/**
+ * \brief Ordena los rangos y fusiona los que se solapan o son contiguos.
+ */
+inline void NormalizeRanges(std::vector<Range<uint64_t>>& ranges)
 {
-    using RangeHeap = std::vector<Range<uint32_t>>;
+    std::sort(ranges.begin(), ranges.end());
 
-    RangeHeap setA(almanac.seedRanges);
-    RangeHeap setB;
+    size_t last = 0;
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        auto& current = ranges[last];
+        const uint64_t currentEnd = current.start + current.length;
 
-    RangeHeap* from = &setA;
-    RangeHeap* to = &setB;
+        if (ranges[i].start <= currentEnd)
+            current.length = std::max(currentEnd, ranges[i].start + ranges[i].length) - current.start;
+        else
+            ranges[++last] = ranges[i];
+    }
 
-    for (const auto& map : almanac.maps)
+    if (!ranges.empty()) ranges.resize(last + 1);
+}
+
+/**
+ * \brief Traslada un conjunto de rangos mediante una tabla.
+ * \param map la función de la tabla.
+ * \param ranges los rangos a trasladar.
+ * \return Los rangos trasladados, sin ordenar.
+ */
+std::vector<Range<uint64_t>> TranslateRanges(const PiecewiseMap& map, std::vector<Range<uint64_t>> ranges)
+{
+    NormalizeRanges(ranges);
+
+    const auto pieces = map.Pieces();
+    const auto pieceEnd = [&](const size_t j)
     {
-        auto node = map.begin();
-        std::optional seedRange = std::make_optional(from->front());
+        return j + 1 < pieces.size() ? pieces[j + 1].start : PiecewiseMap::DOMAIN_END;
+    };
 
-        while (seedRange.has_value() && node != map.end())
+    const size_t blockCount = (ranges.size() + RANGE_BLOCK_SIZE - 1) / RANGE_BLOCK_SIZE;
+    std::vector<std::vector<Range<uint64_t>>> blocks(blockCount);
+
+    std::vector<size_t> blockIndices(blockCount);
+    std::iota(blockIndices.begin(), blockIndices.end(), 0);
+
+    std::for_each(std::execution::par, blockIndices.begin(), blockIndices.end(), [&](const size_t block)
+    {
+        const size_t first = block * RANGE_BLOCK_SIZE;
+        const size_t last = std::min(first + RANGE_BLOCK_SIZE, ranges.size());
+        auto& output = blocks[block];
+
+        size_t j = map.Find(ranges[first].start);
+        for (size_t i = first; i < last; i++)
         {
-            const auto seedStart = seedRange->start;
-            const auto nodeStart = node->fromStart;
+            uint64_t start = ranges[i].start;
+            const uint64_t end = start + ranges[i].length;
 
-            const auto seedEnd = seedRange->start + seedRange->length;
-            const auto nodeEnd = node->fromStart + node->length;
+            while (pieceEnd(j) <= start) j++;
 
-            if (nodeStart < seedEnd)
+            // Partimos el rango por los límites de los trozos que lo cubren.
+            for (size_t k = j; start < end; k++)
             {
-                if (seedStart < nodeEnd)
-                {
-                    if (seedStart < nodeStart)
-                    {
-                        to->emplace_back(seedStart, nodeStart - seedStart);
-                        std::ranges::push_heap(*to, std::greater{});
-                    }
+                const uint64_t partEnd = std::min(end, pieceEnd(k));
+                output.emplace_back(start + pieces[k].offset, partEnd - start);
+                start = partEnd;
+            }
+        }
+    });
 
-                    const auto firstToTranslate = std::max(nodeStart, seedStart);
-                    const auto lastToTranslate = std::min(nodeEnd, seedEnd);
+    std::vector<Range<uint64_t>> res;
+    for (auto& block : blocks)
+        res.insert(res.end(), block.begin(), block.end());
 
-                    to->emplace_back(node->Translate(firstToTranslate), lastToTranslate - firstToTranslate);
-                    std::ranges::push_heap(*to, std::greater{});
+    return res;
+}
+
+uint64_t Second(const Almanac& almanac)
+{
+    std::vector<Range<uint64_t>> ranges;
+    for (const auto& range : almanac.seedRanges)
+        if (range.length > 0) ranges.emplace_back(range);
+
+    for (const auto& map : almanac.maps)
+        ranges = TranslateRanges(PiecewiseMap::FromNodes(map), std::move(ranges));
 
-                    if (seedEnd > nodeEnd)
-                    {
-                        std::ranges::pop_heap(*from, std::greater{});
-                        from->resize(from->size() - 1);
+    return std::ranges::min(ranges, std::less{}, &Range<uint64_t>::start).start;
+}
 
-                        from->emplace_back(nodeEnd, seedEnd - nodeEnd);
-                        std::ranges::push_heap(*from, std::greater{});
+/*
+ * Una vez leídas, las tablas no cambian, así que podemos congelarlas en vectores contiguos en
+ * vez de recorrer los nodos de un árbol. Los inicios de los trozos se guardan en el orden de un
+ * recorrido en anchura de un árbol binario completo (el orden de Eytzinger): los hijos del
+ * elemento «k» son «2k» y «2k + 1», por lo que los primeros niveles comparten líneas de caché.
+ *
+ * Para encontrar el trozo de un valor buscamos el último inicio menor o igual que él, que es el
+ * último nodo del descenso en el que se gira a la derecha. El árbol se rellena con centinelas
+ * mayores que cualquier valor hasta estar completo, de forma que el descenso siempre tiene la
+ * misma cantidad de pasos y no depende de saltos condicionales. Esto también permite hacer el
+ * descenso de varios valores a la vez con instrucciones vectoriales.
+ */
+
+class FrozenMap
+{
+    std::vector<uint64_t> m_starts;
+    std::vector<int64_t> m_offsets;
+    uint32_t m_depth = 0;
 
-                        seedRange = !from->empty() ? std::make_optional(from->front()) : std::nullopt;
-                    }
-                    else
-                    {
-                        std::ranges::pop_heap(*from, std::greater{});
-                        from->resize(from->size() - 1);
+    void Fill(std::span<const PiecewiseMap::Piece> pieces, size_t& next, const size_t k)
+    {
+        if (k >= m_starts.size()) return;
 
-                        seedRange = !from->empty() ? std::make_optional(from->front()) : std::nullopt;
-                    }
-                }
-                else
-                {
-                    ++node;
-                }
-            }
-            else
+        Fill(pieces, next, 2 * k);
+        if (next < pieces.size())
+        {
+            m_starts[k] = pieces[next].start;
+            m_offsets[k] = pieces[next].offset;
+            next++;
+        }
+        Fill(pieces, next, 2 * k + 1);
+    }
+
+    [[nodiscard]] size_t Find(const uint64_t x) const noexcept
+    {
+        size_t k = 1;
+        size_t candidate = 0;
+
+        for (uint32_t level = 0; level < m_depth; level++)
+        {
+            const bool right = m_starts[k] <= x;
+            candidate = right ? k : candidate;
+            k = 2 * k + right;
+        }
+
+        return candidate;
+    }
+
+public:
+    explicit FrozenMap(const PiecewiseMap& map)
+    {
+        const auto pieces = map.Pieces();
+        assert(!pieces.empty() && pieces.front().start == 0);
+
+        // El elemento 0 no se usa, y el árbol tiene 2^depth - 1 nodos.
+        m_depth = std::bit_width(pieces.size());
+        m_starts.assign(static_cast<size_t>(1) << m_depth, PiecewiseMap::DOMAIN_END);
+        m_offsets.assign(static_cast<size_t>(1) << m_depth, 0);
+
+        size_t next = 0;
+        Fill(pieces, next, 1);
+    }
+
+    explicit FrozenMap(const std::set<Node>& map) : FrozenMap(PiecewiseMap::FromNodes(map)) {}
+
+    [[nodiscard]] uint64_t operator()(const uint64_t x) const noexcept
+    {
+        return x + m_offsets[Find(x)];
+    }
+
+    /**
+     * \brief Traslada todos los valores de la lista. Con AVX2 se buscan de ocho
+     * en ocho, usando dos registros de cuatro valores para solapar las lecturas.
+     * \param values los valores a trasladar.
+     */
+    void Translate(const std::span<uint64_t> values) const noexcept
+    {
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        const auto* starts = reinterpret_cast<const long long*>(m_starts.data());
+        const auto* offsets = reinterpret_cast<const long long*>(m_offsets.data());
+        const __m256i one = _mm256_set1_epi64x(1);
+
+        for (; i + 8 <= values.size(); i += 8)
+        {
+            auto* lanes = reinterpret_cast<__m256i*>(values.data() + i);
+
+            const __m256i xA = _mm256_loadu_si256(lanes);
+            const __m256i xB = _mm256_loadu_si256(lanes + 1);
+
+            __m256i kA = one;
+            __m256i kB = one;
+            __m256i candidateA = _mm256_setzero_si256();
+            __m256i candidateB = _mm256_setzero_si256();
+
+            for (uint32_t level = 0; level < m_depth; level++)
             {
-                to->emplace_back(*seedRange);
-                std::ranges::push_heap(*to, std::greater{});
+                const __m256i startA = _mm256_i64gather_epi64(starts, kA, 8);
+                const __m256i startB = _mm256_i64gather_epi64(starts, kB, 8);
 
-                std::ranges::pop_heap(*from, std::greater{});
-                from->resize(from->size() - 1);
+                // Todos los valores son menores que 2^62, así que la comparación
+                // con signo es válida. «left» vale -1 si se gira a la izquierda y 0
+                // si se gira a la derecha, por lo que el siguiente nodo es 2k + 1 + left.
+                const __m256i leftA = _mm256_cmpgt_epi64(startA, xA);
+                const __m256i leftB = _mm256_cmpgt_epi64(startB, xB);
 
-                seedRange = !from->empty() ? std::make_optional(from->front()) : std::nullopt;
+                candidateA = _mm256_blendv_epi8(kA, candidateA, leftA);
+                candidateB = _mm256_blendv_epi8(kB, candidateB, leftB);
+
+                kA = _mm256_add_epi64(_mm256_add_epi64(kA, kA), _mm256_add_epi64(one, leftA));
+                kB = _mm256_add_epi64(_mm256_add_epi64(kB, kB), _mm256_add_epi64(one, leftB));
             }
+
+            const __m256i offsetA = _mm256_i64gather_epi64(offsets, candidateA, 8);
+            const __m256i offsetB = _mm256_i64gather_epi64(offsets, candidateB, 8);
+
+            _mm256_storeu_si256(lanes, _mm256_add_epi64(xA, offsetA));
+            _mm256_storeu_si256(lanes + 1, _mm256_add_epi64(xB, offsetB));
         }
+#endif
+
+        for (; i < values.size(); i++)
+            values[i] = (*this)(values[i]);
+    }
+};
+
+/**
+ * \brief Congela las siete tablas del almanaque.
+ */
+inline std::vector<FrozenMap> FreezeMaps(const Almanac& almanac)
+{
+    std::vector<FrozenMap> res;
+    for (const auto& map : almanac.maps)
+        res.emplace_back(map);
 
-        while (seedRange.has_value())
+    return res;
+}
+
+uint64_t FirstFrozen(const Almanac& almanac, const std::vector<FrozenMap>& frozenMaps)
+{
+    std::vector<uint64_t> values(almanac.seeds);
+    for (const auto& map : frozenMaps)
+        map.Translate(values);
+
+    return std::ranges::min(values);
+}
+
+uint64_t FirstComposed(const Almanac& almanac, const PiecewiseMap& seedToLocation)
+{
+    std::vector<uint64_t> values(almanac.seeds);
+    FrozenMap(seedToLocation).Translate(values);
+
+    return std::ranges::min(values);
+}
+
+uint64_t SecondComposed(const Almanac& almanac, const PiecewiseMap& seedToLocation)
+{
+    std::vector<Range<uint64_t>> seedRanges;
+    for (const auto& [start, length] : almanac.seedRanges)
+        if (length > 0) seedRanges.emplace_back(start, length);
+
+    return seedToLocation.MinOver(std::move(seedRanges));
+}
+
+/*
+ * También podemos resolver la segunda parte al revés: recorremos los trozos de la función
+ * compuesta en orden creciente de ubicación y, para cada uno, buscamos la menor semilla de su
+ * dominio que esté en algún rango. Como los rangos fusionados están ordenados y no se solapan,
+ * basta con una búsqueda binaria. En cuanto la imagen de un trozo empieza después de la mejor
+ * ubicación encontrada, ninguno de los siguientes puede mejorarla y terminamos.
+ *
+ * Así, el trabajo depende de la cantidad de trozos recorridos y no de la de rangos de semillas,
+ * salvo por ordenarlos una vez.
+ */
+
+uint64_t SecondReverse(const Almanac& almanac, const PiecewiseMap& seedToLocation)
+{
+    std::vector<Range<uint64_t>> seedRanges;
+    for (const auto& range : almanac.seedRanges)
+        if (range.length > 0) seedRanges.emplace_back(range);
+
+    NormalizeRanges(seedRanges);
+
+    const auto pieces = seedToLocation.Pieces();
+    std::vector<std::pair<uint64_t, size_t>> images;
+    images.reserve(pieces.size());
+
+    for (size_t i = 0; i < pieces.size(); i++)
+        images.emplace_back(pieces[i].start + pieces[i].offset, i);
+
+    std::ranges::sort(images);
+
+    uint64_t res = std::numeric_limits<uint64_t>::max();
+    for (const auto& [location, i] : images)
+    {
+        if (location >= res) break;
+
+        const uint64_t start = pieces[i].start;
+        const uint64_t end = i + 1 < pieces.size() ? pieces[i + 1].start : PiecewiseMap::DOMAIN_END;
+
+        // Buscamos el primer rango de semillas que termina después del inicio del trozo.
+        const auto range = std::ranges::partition_point(seedRanges, [start](const Range<uint64_t>& r)
         {
-            to->emplace_back(*seedRange);
-            std::ranges::push_heap(*to, std::greater{});
+            return r.start + r.length <= start;
+        });
 
-            std::ranges::pop_heap(*from, std::greater{});
-            from->resize(from->size() - 1);
+        if (range != seedRanges.end() && range->start < end)
+            res = std::min(res, std::max(range->start, start) + pieces[i].offset);
+    }
+
+    return res;
+}
+
+/**
+ * \brief Genera un almanaque aleatorio. Cada tabla tiene «entries» intervalos que
+ * no se solapan, y hay «seedCount» semillas con rangos de hasta «maxSeedLength».
+ */
+Almanac GenerateAlmanac(
+    const size_t entries,
+    const size_t seedCount,
+    const uint32_t maxSeedLength,
+    std::mt19937_64& rng
+)
+{
+    std::uniform_int_distribution<uint32_t> value;
+    Almanac almanac;
 
-            seedRange = !from->empty() ? std::make_optional(from->front()) : std::nullopt;
+    for (auto& map : almanac.maps)
+    {
+        std::vector<uint32_t> cuts(2 * entries);
+        for (auto& cut : cuts) cut = value(rng);
+        std::ranges::sort(cuts);
+
+        for (size_t i = 0; i < entries; i++)
+        {
+            const uint32_t fromStart = cuts[2 * i];
+            const uint32_t length = cuts[2 * i + 1] - fromStart;
+            if (length == 0) continue;
+
+            const uint32_t toStart = std::uniform_int_distribution<uint32_t>(0, ~length)(rng);
+            map.emplace(toStart, fromStart, length);
         }
+    }
 
-        RangeHeap* tmp = from;
-        from = to;
-        to = tmp;
+    for (size_t i = 0; i < seedCount; i++)
+    {
+        const uint32_t seedStart = value(rng) / 2;
+        const uint32_t seedLength = value(rng) % maxSeedLength + 1;
+
+        almanac.seeds.emplace_back(seedStart);
+        almanac.seedRanges.emplace_back(seedStart, seedLength);
+    }
+
+    std::ranges::make_heap(almanac.seeds, std::greater{});
+    std::ranges::make_heap(almanac.seedRanges, std::greater{});
+
+    return almanac;
+}
+
+/**
+ * \brief Mide el tiempo de una función y lo muestra junto a su resultado.
+ */
+template<typename F>
+void Measure(const char* name, F&& f)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    using std::chrono::high_resolution_clock;
+
+    const auto start = high_resolution_clock::now();
+    const auto res = f();
+    const auto elapsed = high_resolution_clock::now() - start;
+
+    std::cout << name << ": " << res << " (" << duration_cast<microseconds>(elapsed) << ")" << std::endl;
+}
+
+void RunBenchmark()
+{
+    std::mt19937_64 rng(2023);
+
+    std::cout << "Primera parte" << std::endl;
+    for (const size_t entries : { 64, 1024, 4096, 16384 })
+    {
+        const Almanac almanac = GenerateAlmanac(entries, 1'000'000, 1'000'000, rng);
+        std::cout << "Tablas de " << entries << " intervalos:" << std::endl;
+
+        Measure("  Árbol", [&] { return static_cast<uint64_t>(First(almanac)); });
+
+        const auto frozenMaps = FreezeMaps(almanac);
+        Measure("  Eytzinger", [&] { return FirstFrozen(almanac, frozenMaps); });
+
+        const PiecewiseMap seedToLocation = ComposeMaps(almanac);
+        Measure("  Compuesta", [&] { return FirstComposed(almanac, seedToLocation); });
     }
 
-    return from->front().start;
+    // Para la segunda parte usamos pocos intervalos por tabla y muchos rangos de semillas
+    // grandes. El tiempo de los métodos que usan la función compuesta incluye componerla.
+    std::cout << "Segunda parte" << std::endl;
+    for (const size_t entries : { 16, 256, 4096 })
+    {
+        const Almanac almanac = GenerateAlmanac(entries, 1'000'000, 100'000'000, rng);
+        std::cout << "Tablas de " << entries << " intervalos:" << std::endl;
+
+        Measure("  Hacia delante", [&] { return Second(almanac); });
+        Measure("  Compuesta", [&] { return SecondComposed(almanac, ComposeMaps(almanac)); });
+        Measure("  Inversa", [&] { return SecondReverse(almanac, ComposeMaps(almanac)); });
+    }
+}
+
+/**
+ * \brief Comprueba que un intervalo de la entrada termina antes del final del dominio.
+ */
+void CheckDomain(const uint64_t start, const uint64_t length)
+{
+    if (start >= PiecewiseMap::DOMAIN_END || length >= PiecewiseMap::DOMAIN_END - start)
+        throw std::exception("El almanaque se sale del dominio de 2^62");
 }
 
 int main()
@@ -224,6 +717,12 @@ int main()
     using std::chrono::milliseconds;
     using std::chrono::high_resolution_clock;
 
+    if constexpr (RUN_BENCHMARK)
+    {
+        RunBenchmark();
+        return 0;
+    }
+
     const auto start = high_resolution_clock::now();
 
 
@@ -235,8 +734,9 @@ int main()
         input.ignore(7);
         while (std::isdigit(input.peek()))
         {
-            uint32_t seedStart, seedLength;
+            uint64_t seedStart, seedLength;
             input >> seedStart >> seedLength >> std::ws;
+            CheckDomain(seedStart, seedLength);
 
             almanac.seeds.emplace_back(seedStart);
             almanac.seeds.emplace_back(seedLength);
@@ -252,15 +752,29 @@ int main()
             input.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             while (std::isdigit(input.peek()))
             {
-                uint32_t toStart, fromStart, length;
+                uint64_t toStart, fromStart, length;
                 input >> toStart >> fromStart >> length >> std::ws;
+                CheckDomain(toStart, length);
+                CheckDomain(fromStart, length);
                 map.emplace(toStart, fromStart, length);
             }
         }
     }
 
-    std::cout << "Primera parte: " << First(almanac) << std::endl;
-    std::cout << "Segunda parte: " << Second(almanac) << std::endl;
+    if constexpr (COMPOSE_MAPS)
+    {
+        const PiecewiseMap seedToLocation = ComposeMaps(almanac);
+
+        std::cout << "Primera parte: " << FirstComposed(almanac, seedToLocation) << std::endl;
+        std::cout << "Segunda parte: " << (REVERSE_LOOKUP
+            ? SecondReverse(almanac, seedToLocation)
+            : SecondComposed(almanac, seedToLocation)) << std::endl;
+    }
+    else
+    {
+        std::cout << "Primera parte: " << FirstFrozen(almanac, FreezeMaps(almanac)) << std::endl;
+        std::cout << "Segunda parte: " << Second(almanac) << std::endl;
+    }
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::clog << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
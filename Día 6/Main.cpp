@@ -1,59 +1,214 @@
-#include <array>
+#include <vector>
+#include <string>
+#include <span>
+#include <sstream>
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../Compartido/Int128.h"
+
 struct Record
 {
-    uint32_t duration;
-    uint32_t distance;
+    uint64_t duration;
+    uint64_t distance;
 };
 
-uint32_t First(const std::array<Record, 4>& records)
+/*
+ * Si mantenemos el botón «t» milisegundos, recorremos «t * (T - t)» milímetros. Los tiempos que
+ * baten el récord son los enteros estrictamente entre las raíces de «t^2 - T t + D = 0», que son
+ * simétricas respecto a «T / 2». Basta con encontrar el menor tiempo «lo» que bate el récord, y
+ * la cantidad de tiempos es «T - 2 lo + 1».
+ *
+ * Calculamos la raíz con enteros para no perder precisión y corregimos «lo» comprobando
+ * directamente la distancia en los tiempos vecinos.
+ */
+
+/**
+ * \brief Calcula la raíz cuadrada entera, redondeada hacia abajo, mediante el método de Newton.
+ */
+template<typename T>
+T ISqrt(const T n)
 {
-    uint32_t res = 1;
-    for (const auto& [duration, distance] : records)
+    if (n < 2) return n;
+
+    uint32_t bits = 0;
+    for (T m = n; m != 0; m >>= 1) bits++;
+
+    // Empezamos con una potencia de dos mayor o igual que la raíz, de forma que
+    // la sucesión decrece hasta alcanzarla.
+    T x = static_cast<T>(1) << ((bits + 1) / 2);
+    T y = (x + n / x) >> 1;
+
+    while (y < x)
     {
-        const auto b = static_cast<float>(duration);
-        const auto c = -static_cast<float>(distance);
+        x = y;
+        y = (x + n / x) >> 1;
+    }
+
+    return x;
+}
+
+/**
+ * \brief Calcula la cantidad de tiempos que baten el récord de una carrera de forma exacta.
+ * La duración ha de ser menor que 2^64 y la distancia que 2^125 para que «T^2» y «4 D» quepan
+ * en 128 bits.
+ */
+UInt128 CountWays(const UInt128 duration, const UInt128 distance)
+{
+    if (duration >> 64 != 0 || distance >> 125 != 0) throw std::exception("La carrera no cabe en 128 bits");
+
+    const UInt128 square = duration * duration;
+    if (square <= 4 * distance) return 0;
 
-        assert(b * b + 4 * c > 0);
-        const float sqrtDiscriminant = std::sqrt(b * b + 4 * c);
+    const auto beats = [&](const UInt128 t) { return t * (duration - t) > distance; };
 
-        const float fRootA = (b - sqrtDiscriminant) * 0.5f;
-        const float fRootB = (b + sqrtDiscriminant) * 0.5f;
+    const UInt128 root = ISqrt(square - 4 * distance);
+    UInt128 lo = (duration - root) / 2;
 
-        assert(fRootA > 0);
-        assert(fRootB > fRootA);
+    if (!beats(lo)) lo += 1;
+    if (lo > 0 && beats(lo - 1)) lo -= 1;
 
-        const auto rootA = static_cast<uint32_t>(std::ceil(fRootA));
-        const auto rootB = static_cast<uint32_t>(std::ceil(fRootB));
+    if (2 * lo > duration) return 0;
+    return duration - 2 * lo + 1;
+}
+
+/*
+ * Para muchas carreras pequeñas usamos instrucciones vectoriales con números de coma flotante.
+ * Si la duración es menor o igual que 2^26 y la distancia menor que 2^50, todos los valores
+ * intermedios son enteros menores que 2^53, que se representan sin error. La raíz puede
+ * redondearse al entero siguiente, pero la corrección posterior es también exacta.
+ */
+
+constexpr uint64_t VECTOR_MAX_DURATION = static_cast<uint64_t>(1) << 26;
+constexpr uint64_t VECTOR_MAX_DISTANCE = static_cast<uint64_t>(1) << 50;
+
+/**
+ * \brief Calcula la cantidad de tiempos que baten el récord de cada carrera.
+ * \param records las carreras.
+ * \param ways el vector donde se escribe el resultado de cada carrera.
+ */
+void CountWays(const std::span<const Record> records, const std::span<uint64_t> ways)
+{
+    assert(ways.size() >= records.size());
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const auto isSmall = [](const Record& r)
+    {
+        return r.duration <= VECTOR_MAX_DURATION && r.distance < VECTOR_MAX_DISTANCE;
+    };
+
+    for (; i + 4 <= records.size(); i += 4)
+    {
+        const auto lanes = records.subspan(i, 4);
+        if (!std::ranges::all_of(lanes, isSmall))
+        {
+            for (size_t k = 0; k < 4; k++)
+                ways[i + k] = static_cast<uint64_t>(CountWays(lanes[k].duration, lanes[k].distance));
+
+            continue;
+        }
 
-        res *= rootB - rootA;
+        const __m256d duration = _mm256_setr_pd(
+            static_cast<double>(lanes[0].duration), static_cast<double>(lanes[1].duration),
+            static_cast<double>(lanes[2].duration), static_cast<double>(lanes[3].duration)
+        );
+        const __m256d distance = _mm256_setr_pd(
+            static_cast<double>(lanes[0].distance), static_cast<double>(lanes[1].distance),
+            static_cast<double>(lanes[2].distance), static_cast<double>(lanes[3].distance)
+        );
+
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        const __m256d discriminant = _mm256_sub_pd(
+            _mm256_mul_pd(duration, duration),
+            _mm256_mul_pd(_mm256_set1_pd(4.0), distance)
+        );
+        const __m256d root = _mm256_floor_pd(_mm256_sqrt_pd(_mm256_max_pd(discriminant, zero)));
+        __m256d lo = _mm256_floor_pd(_mm256_mul_pd(_mm256_sub_pd(duration, root), _mm256_set1_pd(0.5)));
+
+        const auto travelled = [&](const __m256d t) { return _mm256_mul_pd(t, _mm256_sub_pd(duration, t)); };
+
+        // Si «lo» no bate el récord avanzamos uno, y si el anterior lo bate retrocedemos uno.
+        lo = _mm256_add_pd(lo, _mm256_and_pd(_mm256_cmp_pd(travelled(lo), distance, _CMP_LE_OQ), one));
+        const __m256d previous = _mm256_sub_pd(lo, one);
+        lo = _mm256_sub_pd(lo, _mm256_and_pd(_mm256_cmp_pd(travelled(previous), distance, _CMP_GT_OQ), one));
+
+        __m256d count = _mm256_add_pd(_mm256_sub_pd(duration, _mm256_add_pd(lo, lo)), one);
+        count = _mm256_and_pd(count, _mm256_cmp_pd(discriminant, zero, _CMP_GT_OQ));
+        count = _mm256_max_pd(count, zero);
+
+        alignas(32) double counts[4];
+        _mm256_store_pd(counts, count);
+
+        for (size_t k = 0; k < 4; k++)
+            ways[i + k] = static_cast<uint64_t>(counts[k]);
     }
+#endif
+
+    for (; i < records.size(); i++)
+        ways[i] = static_cast<uint64_t>(CountWays(records[i].duration, records[i].distance));
+}
 
+/**
+ * \brief Convierte un entero de 128 bits en texto.
+ */
+std::string ToString(UInt128 value)
+{
+    std::string res;
+    do
+    {
+        res += static_cast<char>('0' + static_cast<uint32_t>(value % 10));
+        value /= 10;
+    }
+    while (value != 0);
+
+    std::ranges::reverse(res);
     return res;
 }
 
-uint64_t Second(const uint64_t joinedDuration, const uint64_t joinedDistance)
+/**
+ * \brief Convierte una secuencia de dígitos en un entero de 128 bits.
+ */
+UInt128 ParseUInt128(const std::string& digits)
 {
-    const auto b = static_cast<double>(joinedDuration);
-    const auto c = -static_cast<double>(joinedDistance);
+    constexpr UInt128 max = ~static_cast<UInt128>(0);
 
-    const double discriminant = b * b + 4 * c;
-    assert(discriminant > 0);
+    UInt128 res = 0;
+    for (const char c : digits)
+    {
+        const uint32_t digit = static_cast<uint32_t>(c - '0');
+        if (res > (max - digit) / 10) throw std::exception("El número no cabe en 128 bits");
+        res = res * 10 + digit;
+    }
 
-    const double fRootA = (-b + sqrt(discriminant)) * -0.5;
-    const double fRootB = (-b + -sqrt(discriminant)) * -0.5;
+    return res;
+}
 
-    assert(fRootA > 0);
-    assert(fRootB > fRootA);
+uint64_t First(const std::vector<Record>& records)
+{
+    std::vector<uint64_t> ways(records.size());
+    CountWays(records, ways);
 
-    const auto rootA = static_cast<uint64_t>(std::ceil(fRootA));
-    const auto rootB = static_cast<uint64_t>(std::ceil(fRootB));
+    uint64_t res = 1;
+    for (const uint64_t count : ways)
+        res *= count;
 
-    return rootB - rootA;
+    return res;
+}
+
+UInt128 Second(const UInt128 joinedDuration, const UInt128 joinedDistance)
+{
+    return CountWays(joinedDuration, joinedDistance);
 }
 
 int main()
@@ -64,41 +219,40 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    std::array<Record, 4> records;
+    std::vector<Record> records;
 
-    uint64_t joinedDuration = 0;
-    uint64_t joinedDistance = 0;
+    std::string joinedDuration;
+    std::string joinedDistance;
 
     {
         std::ifstream input("input", std::ios::binary);
-        constexpr static int pow10[5]{ 1, 10, 100, 1000, 10000 };
 
-        input.ignore(11);
-        input >> std::ws;
-        for (auto& [duration, _] : records)
+        // Cada línea tiene una etiqueta seguida de los números, que pueden tener cualquier
+        // longitud. Para la segunda parte concatenamos sus dígitos.
+        std::string line;
+        std::string number;
+
+        std::getline(input, line);
+        std::istringstream durations(line.substr(line.find(':') + 1));
+        while (durations >> number)
         {
-            const auto numberStart = input.tellg();
-            input >> duration;
-            const auto numberEnd = input.tellg();
-            input >> std::ws;
-            joinedDuration = joinedDuration * pow10[numberEnd - numberStart] + duration;
+            records.emplace_back(std::stoull(number), 0);
+            joinedDuration += number;
         }
 
-        input.ignore(11);
-        input >> std::ws;
+        std::getline(input, line);
+        std::istringstream distances(line.substr(line.find(':') + 1));
         for (auto& [_, distance] : records)
         {
-            const auto numberStart = input.tellg();
-            input >> distance;
-            const auto numberEnd = input.tellg();
-            input >> std::ws;
-            joinedDistance = joinedDistance * pow10[numberEnd - numberStart] + distance;
+            distances >> number;
+            distance = std::stoull(number);
+            joinedDistance += number;
         }
     }
 
 
     std::cout << "Primera parte: " << First(records) << std::endl;
-    std::cout << "Segunda parte: " << Second(joinedDuration, joinedDistance) << std::endl;
+    std::cout << "Segunda parte: " << ToString(Second(ParseUInt128(joinedDuration), ParseUInt128(joinedDistance))) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
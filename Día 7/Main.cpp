@@ -1,165 +1,351 @@
 #include <array>
-#include <set>
-#include <unordered_map>
-#include <ranges>
+#include <vector>
+#include <span>
+#include <string_view>
+#include <numeric>
+#include <execution>
+#include <thread>
 #include <cassert>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 enum class HandKind
 {
     HighCard, OnePair, TwoPair, ThreeOfAKind, FullHouse, FourOfAKind, FiveOfAKind
 };
 
-struct Hand
+/*
+ * El tipo de mano sólo depende de cuántas veces se repite cada carta. Como firma usamos la
+ * suma de los cuadrados de las repeticiones, que se calcula comparando cada par de cartas sin
+ * ramas ni memoria auxiliar: cada carta cuenta uno consigo misma y dos por cada pareja igual.
+ * Con cinco cartas o menos, la firma identifica las repeticiones sin ambigüedad.
+ *
+ * Los comodines se cuentan aparte y no entran en la firma. Lo mejor es sumarlos siempre a la
+ * carta más repetida, así que la tabla, indexada por comodines y firma, ya da el tipo final.
+ */
+
+constexpr size_t HAND_SIZE = 5;
+constexpr size_t MAX_SIGNATURE = HAND_SIZE * HAND_SIZE;
+
+typedef std::array<std::array<HandKind, MAX_SIGNATURE + 1>, HAND_SIZE + 1> KindTable;
+
+constexpr KindTable KIND_TABLE = []
 {
-    std::array<char, 5> cards;
-    HandKind kind;
-    uint32_t bid;
+    KindTable table{};
 
-    friend std::strong_ordering operator<=>(const Hand& a, const Hand& b)
+    const auto classify = [](const uint32_t largest, const uint32_t second)
+    {
+        if (largest == 5) return HandKind::FiveOfAKind;
+        if (largest == 4) return HandKind::FourOfAKind;
+        if (largest == 3) return second == 2 ? HandKind::FullHouse : HandKind::ThreeOfAKind;
+        if (largest == 2) return second == 2 ? HandKind::TwoPair : HandKind::OnePair;
+        return HandKind::HighCard;
+    };
+
+    // Recorremos las repeticiones de las cartas normales en orden decreciente, «a >= b >= ...».
+    for (uint32_t jokers = 0; jokers <= HAND_SIZE; jokers++)
+    for (uint32_t a = 0; a <= HAND_SIZE; a++)
+    for (uint32_t b = 0; b <= a; b++)
+    for (uint32_t c = 0; c <= b; c++)
+    for (uint32_t d = 0; d <= c; d++)
+    for (uint32_t e = 0; e <= d; e++)
     {
-        if (a.kind != b.kind) return a.kind <=> b.kind;
-        return a.cards <=> b.cards;
+        if (a + b + c + d + e + jokers != HAND_SIZE) continue;
+
+        const uint32_t signature = a * a + b * b + c * c + d * d + e * e;
+        table[jokers][signature] = classify(a + jokers, b);
     }
 
-    Hand(const std::array<char, 5>& input, uint32_t bid) : cards(input), bid(bid), kind(HandKind::HighCard) {}
-};
+    return table;
+}();
 
-class HandWithoutJoker : public Hand
+/**
+ * \brief Calcula el tipo de una mano.
+ * \tparam Joker la carta que actúa como comodín, o «0» si no hay comodín.
+ * \param cards las cartas de la mano.
+ */
+template<char Joker>
+[[nodiscard]] constexpr HandKind Classify(const std::array<char, HAND_SIZE>& cards) noexcept
 {
-    HandKind CalculateHandKind()
-    {
-        std::unordered_map<char, uint32_t> cardMap;
-        for (char card : cards)
-            cardMap[card] += 1;
-
-        switch (cardMap.size()) {
-        case 5: return HandKind::HighCard;
-        case 4: return HandKind::OnePair;
-        case 1: return HandKind::FiveOfAKind;
-
-        case 3:
-            for (const auto& [_, reps] : cardMap) {
-                if (reps == 3)
-                    return HandKind::ThreeOfAKind;
-            }
-            return HandKind::TwoPair;
+    uint32_t jokers = 0;
+    uint32_t signature = 0;
 
-        case 2:
-            if (cardMap.begin()->second == 4 || cardMap.begin()->second == 1)
-                return HandKind::FourOfAKind;
-            return HandKind::FullHouse;
-        }
+    for (size_t i = 0; i < HAND_SIZE; i++)
+    {
+        const uint32_t normal = cards[i] != Joker;
+        jokers += 1 - normal;
+        signature += normal;
 
-        throw std::exception();
+        for (size_t k = i + 1; k < HAND_SIZE; k++)
+            signature += 2 * (normal & static_cast<uint32_t>(cards[i] == cards[k]));
     }
 
-public:
-    explicit HandWithoutJoker(const std::array<char, 5>& input, uint32_t bid) : Hand(input, bid) {
-        for (char& c : cards)
+    return KIND_TABLE[jokers][signature];
+}
+
+/**
+ * \brief Calcula el tipo de muchas manos a la vez.
+ * \tparam Joker la carta que actúa como comodín, o «0» si no hay comodín.
+ * \param hands las cartas de cada mano, tal y como aparecen en la entrada.
+ * \param kinds el vector donde se escribe el tipo de cada mano.
+ */
+template<char Joker>
+void ClassifyHands(const std::span<const std::array<char, HAND_SIZE>> hands, const std::span<HandKind> kinds)
+{
+    assert(kinds.size() >= hands.size());
+    size_t h = 0;
+
+#if defined(__AVX2__)
+    // Trasponemos 32 manos para tener cada posición de carta en un vector y calculamos
+    // las firmas de todas a la vez. Las comparaciones dan «-1», así que restamos.
+    constexpr size_t LANES = 32;
+
+    for (; h + LANES <= hands.size(); h += LANES)
+    {
+        alignas(32) char columns[HAND_SIZE][LANES];
+        for (size_t lane = 0; lane < LANES; lane++)
+            for (size_t i = 0; i < HAND_SIZE; i++)
+                columns[i][lane] = hands[h + lane][i];
+
+        __m256i cards[HAND_SIZE];
+        for (size_t i = 0; i < HAND_SIZE; i++)
+            cards[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(columns[i]));
+
+        const __m256i jokerCard = _mm256_set1_epi8(Joker);
+        __m256i jokers = _mm256_setzero_si256();
+        __m256i signature = _mm256_setzero_si256();
+
+        for (size_t i = 0; i < HAND_SIZE; i++)
         {
-            switch (c) {
-            case 'A': c = 14; break;
-            case 'K': c = 13; break;
-            case 'Q': c = 12; break;
-            case 'J': c = 11; break;
-            case 'T': c = 10; break;
-            default:
-                assert(std::isdigit(c));
-                c -= '0';
-                break;
+            const __m256i isJoker = _mm256_cmpeq_epi8(cards[i], jokerCard);
+            jokers = _mm256_sub_epi8(jokers, isJoker);
+            signature = _mm256_add_epi8(signature, _mm256_andnot_si256(isJoker, _mm256_set1_epi8(1)));
+
+            for (size_t k = i + 1; k < HAND_SIZE; k++)
+            {
+                const __m256i pair = _mm256_andnot_si256(isJoker, _mm256_cmpeq_epi8(cards[i], cards[k]));
+                signature = _mm256_sub_epi8(signature, _mm256_add_epi8(pair, pair));
             }
         }
 
-        kind = CalculateHandKind();
+        alignas(32) uint8_t jokerCounts[LANES];
+        alignas(32) uint8_t signatures[LANES];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(jokerCounts), jokers);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(signatures), signature);
+
+        for (size_t lane = 0; lane < LANES; lane++)
+            kinds[h + lane] = KIND_TABLE[jokerCounts[lane]][signatures[lane]];
     }
+#endif
+
+    for (; h < hands.size(); h++)
+        kinds[h] = Classify<Joker>(hands[h]);
+}
+
+/*
+ * Cada variante del juego es una política con la carta que actúa como comodín y el orden de
+ * las cartas, de menor a mayor. «Hand» genera en tiempo de compilación la tabla con el valor de
+ * cada carta, de forma que cada variante tiene su propio código sin comprobaciones en ejecución.
+ */
+
+struct StandardRules
+{
+    static constexpr char JOKER = 0;
+    static constexpr std::string_view ORDER = "23456789TJQKA";
 };
 
-class HandWithJoker : public Hand
+struct JokerRules
 {
-    HandKind CalculateHandKind()
-    {
-        std::unordered_map<char, uint32_t> cardMap;
-        uint32_t jokers = 0;
+    static constexpr char JOKER = 'J';
+    static constexpr std::string_view ORDER = "J23456789TQKA";
+};
 
-        for (char card : cards)
-            if (card != 1) cardMap[card] += 1;
-            else jokers++;
+template<typename Rules>
+class Hand
+{
+    static_assert(Rules::ORDER.size() <= 16, "El valor de cada carta ha de caber en 4 bits");
 
-        if (jokers == 5) return HandKind::FiveOfAKind;
-        uint32_t maxReps = std::ranges::max(cardMap | std::ranges::views::values);
+    // Valor de las cartas que no existen en la variante. Al combinar valores con «|» deja
+    // activo un bit que ninguna carta válida usa.
+    static constexpr uint8_t NO_RANK = 0xFF;
 
-        switch (maxReps + jokers) {
-        case 5: return HandKind::FiveOfAKind;
-        case 4: return HandKind::FourOfAKind;
-        case 1: return HandKind::HighCard;
+    static constexpr std::array<uint8_t, 256> RANKS = []
+    {
+        std::array<uint8_t, 256> ranks;
+        ranks.fill(NO_RANK);
+        for (size_t i = 0; i < Rules::ORDER.size(); i++)
+            ranks[static_cast<unsigned char>(Rules::ORDER[i])] = static_cast<uint8_t>(i);
 
-        case 3:
-            if (cardMap.size() == 2) return HandKind::FullHouse;
-            return HandKind::ThreeOfAKind;
+        return ranks;
+    }();
 
-        case 2:
-            if (jokers) return HandKind::OnePair;
-            return cardMap.size() == 3 ? HandKind::TwoPair : HandKind::OnePair;
-        }
+public:
+    static constexpr char JOKER = Rules::JOKER;
 
-        throw std::exception();
-    }
+    /**
+     * \brief Calcula la clave de ordenación de la mano: el tipo en los bits altos y
+     * el valor de cada carta, que cabe en 4 bits, debajo.
+     */
+    [[nodiscard]] static constexpr uint32_t Key(const std::array<char, HAND_SIZE>& cards, const HandKind kind)
+    {
+        uint32_t key = static_cast<uint32_t>(kind);
+        uint8_t seen = 0;
 
-public:
-    explicit HandWithJoker(const std::array<char, 5>& input, uint32_t bid) : Hand(input, bid) {
-        for (char& c : cards)
+        for (const char card : cards)
         {
-            switch (c) {
-            case 'A': c = 14; break;
-            case 'K': c = 13; break;
-            case 'Q': c = 12; break;
-            case 'T': c = 10; break;
-            case 'J': c = 1; break;
-            default:
-                assert(std::isdigit(c));
-                c -= '0';
-                break;
-            }
+            const uint8_t rank = RANKS[static_cast<unsigned char>(card)];
+            key = key << 4 | (rank & 0xF);
+            seen |= rank;
         }
 
-        kind = CalculateHandKind();
+        if (seen > 0xF) throw std::exception("La mano tiene una carta desconocida");
+        return key;
+    }
+
+    // Guardamos la clave y la apuesta juntas para ordenar un único vector de enteros.
+    [[nodiscard]] static constexpr uint64_t Pack(
+        const std::array<char, HAND_SIZE>& cards,
+        const uint32_t bid,
+        const HandKind kind
+    )
+    {
+        return static_cast<uint64_t>(Key(cards, kind)) << 32 | bid;
     }
 };
 
-typedef std::set<HandWithoutJoker, std::greater<Hand>> HandSetWithoutJokers;
-typedef std::set<HandWithJoker, std::greater<Hand>> HandSetWithJokers;
+/*
+ * Empaquetamos las manos para todas las variantes en una sola pasada. Recorremos la lista por
+ * bloques que caben en caché y cada variante clasifica y empaqueta el bloque antes de pasar al
+ * siguiente.
+ */
+
+constexpr size_t PACK_BLOCK_SIZE = 4096;
 
-static uint64_t First(const HandSetWithoutJokers& hands)
+template<typename... Variants>
+std::array<std::vector<uint64_t>, sizeof...(Variants)> PackHands(
+    const std::vector<std::array<char, HAND_SIZE>>& cards,
+    const std::vector<uint32_t>& bids
+)
 {
-    uint32_t res = 0;
+    std::array<std::vector<uint64_t>, sizeof...(Variants)> packed;
+    for (auto& hands : packed)
+        hands.resize(cards.size());
 
-    uint32_t i = static_cast<uint32_t>(hands.size());
-    for (const auto& hand : hands)
+    std::array<HandKind, PACK_BLOCK_SIZE> kinds;
+
+    for (size_t first = 0; first < cards.size(); first += PACK_BLOCK_SIZE)
     {
-        res = res + hand.bid * i;
-        i--;
+        const auto block = std::span(cards).subspan(first, std::min(PACK_BLOCK_SIZE, cards.size() - first));
+        size_t variant = 0;
+
+        ([&]
+        {
+            ClassifyHands<Variants::JOKER>(block, kinds);
+            for (size_t i = 0; i < block.size(); i++)
+                packed[variant][first + i] = Variants::Pack(block[i], bids[first + i], kinds[i]);
+
+            variant++;
+        }(), ...);
     }
 
-    return res;
+    return packed;
 }
 
-static uint64_t Second(const HandSetWithJokers& hands)
+/*
+ * Ordenamos las manos empaquetadas con una ordenación radix LSD de 8 bits por pasada sobre los
+ * 23 bits de la clave. Es estable, así que las manos iguales se conservan en el orden de entrada
+ * en vez de descartarse. Con muchas manos dividimos el vector en bloques, uno por hilo: cada
+ * bloque cuenta sus dígitos y, recorriendo los contadores por dígito y después por bloque,
+ * cada bloque sabe dónde escribir sin sincronizarse con los demás.
+ */
+
+constexpr uint32_t KEY_BITS = 3 + 5 * 4;
+constexpr uint32_t RADIX_BITS = 8;
+constexpr size_t RADIX_SIZE = static_cast<size_t>(1) << RADIX_BITS;
+
+constexpr size_t PARALLEL_THRESHOLD = static_cast<size_t>(1) << 20;
+
+static void RadixSort(std::vector<uint64_t>& entries)
 {
-    uint32_t res = 0;
+    const size_t size = entries.size();
+    const size_t blockCount = size >= PARALLEL_THRESHOLD
+        ? std::max<size_t>(1, std::thread::hardware_concurrency())
+        : 1;
+    const size_t blockSize = (size + blockCount - 1) / blockCount;
+
+    std::vector<size_t> blockIndices(blockCount);
+    std::iota(blockIndices.begin(), blockIndices.end(), 0);
 
-    uint32_t i = static_cast<uint32_t>(hands.size());
-    for (const auto& hand : hands)
+    std::vector<std::array<size_t, RADIX_SIZE>> offsets(blockCount);
+    std::vector<uint64_t> buffer(size);
+
+    for (uint32_t shift = 32; shift < 32 + KEY_BITS; shift += RADIX_BITS)
     {
-        res = res + hand.bid * i;
-        i--;
+        const auto digit = [shift](const uint64_t entry) { return (entry >> shift) & (RADIX_SIZE - 1); };
+        const auto block = [&](const size_t b)
+        {
+            const size_t first = std::min(b * blockSize, size);
+            return std::span(entries).subspan(first, std::min(first + blockSize, size) - first);
+        };
+
+        std::for_each(std::execution::par, blockIndices.begin(), blockIndices.end(), [&](const size_t b)
+        {
+            offsets[b].fill(0);
+            for (const uint64_t entry : block(b))
+                offsets[b][digit(entry)]++;
+        });
+
+        size_t sum = 0;
+        for (size_t d = 0; d < RADIX_SIZE; d++)
+        {
+            for (auto& offset : offsets)
+            {
+                const size_t count = offset[d];
+                offset[d] = sum;
+                sum += count;
+            }
+        }
+
+        std::for_each(std::execution::par, blockIndices.begin(), blockIndices.end(), [&](const size_t b)
+        {
+            for (const uint64_t entry : block(b))
+                buffer[offsets[b][digit(entry)]++] = entry;
+        });
+
+        entries.swap(buffer);
     }
+}
+
+/**
+ * \brief Ordena las manos y suma la apuesta de cada una multiplicada por su posición.
+ * \param entries las manos empaquetadas con «Hand::Pack».
+ */
+static uint64_t TotalWinnings(std::vector<uint64_t>& entries)
+{
+    RadixSort(entries);
+
+    uint64_t res = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+        res += (i + 1) * static_cast<uint32_t>(entries[i]);
 
     return res;
 }
 
+static uint64_t First(std::vector<uint64_t>& hands)
+{
+    return TotalWinnings(hands);
+}
+
+static uint64_t Second(std::vector<uint64_t>& hands)
+{
+    return TotalWinnings(hands);
+}
+
 int main()
 {
     using std::chrono::duration_cast;
@@ -168,27 +354,29 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    HandSetWithoutJokers handSetWithoutJokers;
-    HandSetWithJokers handSetWithJokers;
+    std::vector<std::array<char, 5>> cards;
+    std::vector<uint32_t> bids;
 
     {
         std::ifstream input("input", std::ios::binary);
 
         while (!input.eof())
         {
-            std::array<char, 5> cards{};
+            std::array<char, 5> hand{};
             uint32_t bid;
 
-            input.read(cards.data(), 5);
+            input.read(hand.data(), 5);
             input >> bid >> std::ws;
 
-            handSetWithoutJokers.emplace(cards, bid);
-            handSetWithJokers.emplace(cards, bid);
+            cards.push_back(hand);
+            bids.push_back(bid);
         }
     }
 
-    std::cout << "Primera parte: " << First(handSetWithoutJokers) << std::endl;
-    std::cout << "Segunda parte: " << Second(handSetWithJokers) << std::endl;
+    auto [handsWithoutJokers, handsWithJokers] = PackHands<Hand<StandardRules>, Hand<JokerRules>>(cards, bids);
+
+    std::cout << "Primera parte: " << First(handsWithoutJokers) << std::endl;
+    std::cout << "Segunda parte: " << Second(handsWithJokers) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
@@ -1,15 +1,19 @@
 #include <array>
 #include <vector>
-#include <unordered_map>
+#include <string>
 #include <numeric>
 #include <ranges>
 #include <algorithm>
+#include <bit>
+#include <optional>
+#include <thread>
+#include <utility>
 #include <cassert>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 
-constexpr uint32_t MOVEMENTS_LENGTH = 293;
+#include "../Compartido/Int128.h"
 
 struct Node {
     char name[3];
@@ -22,75 +26,401 @@ struct Node {
 };
 static_assert(sizeof(Node) == sizeof(uint32_t));
 
-template<>
-struct std::hash<Node>
+/*
+ * Al leer la red asignamos a cada nodo un índice consecutivo. Los nombres tienen tres símbolos,
+ * letras o cifras, así que una tabla de 36^3 entradas traduce cualquier nombre a su índice sin
+ * calcular hashes. Las transiciones se guardan en un único vector plano, la izquierda y la
+ * derecha de cada nodo juntas, y los recorridos sólo leen ese vector.
+ */
+
+constexpr uint32_t NAME_SYMBOLS = 36;
+constexpr uint32_t NAME_SPACE = NAME_SYMBOLS * NAME_SYMBOLS * NAME_SYMBOLS;
+constexpr uint16_t NO_NODE = UINT16_MAX;
+
+static_assert(NAME_SPACE < NO_NODE);
+
+[[nodiscard]] constexpr uint32_t NameIndex(const Node& node)
 {
-    std::size_t operator()(const Node& node) const noexcept
+    uint32_t index = 0;
+    for (const char c : node.name)
+    {
+        if ((c < 'A' || c > 'Z') && (c < '0' || c > '9')) throw std::exception("El nombre del nodo no es válido");
+        index = index * NAME_SYMBOLS + (c <= '9' ? 26 + (c - '0') : c - 'A');
+    }
+
+    return index;
+}
+
+enum Movement : uint8_t
+{
+    Left, Right
+};
+
+class Network
+{
+    std::vector<uint16_t> m_ids = std::vector<uint16_t>(NAME_SPACE, NO_NODE);
+    std::vector<Node> m_names;
+    std::vector<uint16_t> m_next;
+
+public:
+    uint16_t Intern(const Node& node)
+    {
+        uint16_t& id = m_ids[NameIndex(node)];
+        if (id == NO_NODE)
+        {
+            id = static_cast<uint16_t>(m_names.size());
+            m_names.push_back(node);
+            m_next.resize(2 * m_names.size(), NO_NODE);
+        }
+
+        return id;
+    }
+
+    void Connect(const Node& node, const Node& left, const Node& right)
     {
-        return std::hash<uint32_t>{}(std::bit_cast<uint32_t>(node));
+        const uint16_t id = Intern(node);
+        const uint16_t leftId = Intern(left);
+        const uint16_t rightId = Intern(right);
+
+        m_next[2 * id + Left] = leftId;
+        m_next[2 * id + Right] = rightId;
+    }
+
+    [[nodiscard]] uint16_t Find(const Node& node) const { return m_ids[NameIndex(node)]; }
+    [[nodiscard]] const Node& Name(const uint16_t id) const noexcept { return m_names[id]; }
+    [[nodiscard]] size_t Size() const noexcept { return m_names.size(); }
+
+    [[nodiscard]] uint16_t Next(const uint16_t id, const Movement movement) const noexcept
+    {
+        return m_next[2 * id + movement];
     }
 };
 
-typedef std::unordered_map<Node, std::pair<Node, Node>> NodeMap;
+/*
+ * En vez de avanzar instrucción a instrucción precalculamos, para cada nodo, en qué nodo
+ * termina una pasada completa de las instrucciones y en qué paso de la pasada llega por primera
+ * vez a una salida. Encima construimos tablas de duplicación: el nodo tras «2^k» pasadas y si
+ * en ellas hay alguna salida. Así la distancia a una salida, o la posición tras «K» pasos, se
+ * obtiene con O(log K) saltos aunque esté a miles de millones de pasos. La distancia a una salida
+ * nunca necesita más niveles que los que cubren tantas pasadas como nodos, así que sólo se
+ * construyen esos y los demás se añaden cuando una consulta de posición los necesita.
+ */
+
+constexpr uint32_t NO_EXIT = 0;
+
+class JumpTable
+{
+    const Network& m_network;
+    const std::vector<Movement>& m_movements;
 
-static uint32_t First(const NodeMap& nodeMap, const std::vector<char>& movements) {
+    std::vector<uint32_t> m_firstExit;
+    std::vector<std::vector<uint16_t>> m_jumps;
+    std::vector<std::vector<uint8_t>> m_exits;
+
+    /**
+     * \brief Añade niveles de duplicación hasta tener al menos «count».
+     */
+    void Extend(const size_t count)
+    {
+        const size_t size = m_network.Size();
+        while (m_jumps.size() < count)
+        {
+            const auto& jumps = m_jumps.back();
+            const auto& exits = m_exits.back();
+
+            std::vector<uint16_t> nextJumps(size);
+            std::vector<uint8_t> nextExits(size);
+
+            for (uint16_t id = 0; id < size; id++)
+            {
+                nextJumps[id] = jumps[jumps[id]];
+                nextExits[id] = exits[id] | exits[jumps[id]];
+            }
+
+            m_jumps.push_back(std::move(nextJumps));
+            m_exits.push_back(std::move(nextExits));
+        }
+    }
+
+public:
+    /**
+     * \brief Construye las tablas de saltos.
+     * \param network la red.
+     * \param movements las instrucciones, que se repiten indefinidamente.
+     * \param isExit indica si un nodo es una salida.
+     */
+    template<typename Predicate>
+    JumpTable(const Network& network, const std::vector<Movement>& movements, Predicate isExit)
+        : m_network(network), m_movements(movements), m_firstExit(network.Size(), NO_EXIT)
+    {
+        const size_t size = network.Size();
+
+        m_jumps.emplace_back(size);
+        m_exits.emplace_back(size);
+
+        for (uint16_t id = 0; id < size; id++)
+        {
+            uint16_t current = id;
+            for (uint32_t step = 1; step <= movements.size(); step++)
+            {
+                current = network.Next(current, movements[step - 1]);
+                if (m_firstExit[id] == NO_EXIT && isExit(current)) m_firstExit[id] = step;
+            }
+
+            m_jumps[0][id] = current;
+            m_exits[0][id] = m_firstExit[id] != NO_EXIT;
+        }
+
+        Extend(std::bit_width(size));
+    }
+
+    /**
+     * \brief Calcula la cantidad de pasos hasta la primera salida, empezando por la
+     * primera instrucción.
+     */
+    [[nodiscard]] uint64_t DistanceToExit(const uint16_t from) const
+    {
+        uint16_t current = from;
+        uint64_t passes = 0;
+
+        // Saltamos todas las pasadas que no pasan por ninguna salida, de mayor a menor.
+        // Tras tantas pasadas como nodos, el nodo al empezar cada pasada ya se repite,
+        // así que basta con los niveles que cubren esa cantidad.
+        const size_t levels = std::min<size_t>(m_jumps.size(), std::bit_width(m_network.Size()));
+        for (size_t k = levels; k-- > 0;)
+        {
+            if (!m_exits[k][current])
+            {
+                current = m_jumps[k][current];
+                passes += static_cast<uint64_t>(1) << k;
+            }
+        }
+
+        if (m_firstExit[current] == NO_EXIT) throw std::exception("No se alcanza ninguna salida");
+        return passes * m_movements.size() + m_firstExit[current];
+    }
+
+    /**
+     * \brief Calcula el nodo en el que estamos tras una cantidad de pasos, empezando por
+     * la primera instrucción. Añade los niveles de duplicación que falten para «steps».
+     */
+    [[nodiscard]] uint16_t Advance(const uint16_t from, const uint64_t steps)
+    {
+        uint16_t current = from;
+        const uint64_t passes = steps / m_movements.size();
+
+        const size_t levels = std::bit_width(passes);
+        Extend(levels);
+
+        for (size_t k = 0; k < levels; k++)
+            if (passes >> k & 1) current = m_jumps[k][current];
+
+        for (size_t step = 0; step < steps % m_movements.size(); step++)
+            current = m_network.Next(current, m_movements[step]);
+
+        return current;
+    }
+};
+
+static uint64_t First(const Network& network, const std::vector<Movement>& movements) {
     constexpr Node start{ 'A', 'A', 'A' };
-    constexpr Node end { 'Z', 'Z', 'Z' };
+    constexpr Node end{ 'Z', 'Z', 'Z' };
+
+    const uint16_t startId = network.Find(start);
+    const uint16_t endId = network.Find(end);
+    if (startId == NO_NODE || endId == NO_NODE) throw std::exception("La red no tiene los nodos AAA y ZZZ");
 
-    Node currentNode = start;
-    std::pair<Node, Node> destinations = nodeMap.at(currentNode);
+    const JumpTable table(network, movements, [endId](const uint16_t id) { return id == endId; });
+
+    return table.DistanceToExit(startId);
+}
 
-    uint32_t steps = 0;
-    while (steps < 1'000'000) {
-        char movement = movements[steps % movements.size()];
+/*
+ * Para la segunda parte analizamos cada fantasma por separado. Su estado es el nodo junto con
+ * la instrucción actual, así que tras como mucho «nodos * instrucciones» pasos entra en un ciclo,
+ * que detectamos con el algoritmo de Brent. Guardamos los pasos con salida antes del ciclo y,
+ * dentro del ciclo, el resto de esos pasos módulo su longitud.
+ *
+ * Un paso es la solución si todos los fantasmas están en una salida. Antes de que todos hayan
+ * entrado en su ciclo comprobamos los pasos uno a uno. Después, cada fantasma impone que el paso
+ * sea congruente con alguno de sus restos, y combinamos todas las posibilidades con el teorema
+ * chino del resto generalizado, que admite módulos que no son coprimos.
+ */
 
-        currentNode = movement == 'L' ? destinations.first : destinations.second;
-        steps++;
+struct GhostCycle
+{
+    uint64_t start;
+    uint64_t length;
+    std::vector<uint64_t> tailExits;
+    std::vector<uint64_t> cycleExits;
 
-        destinations = nodeMap.at(currentNode);
-        if (currentNode == end) return steps;
+    [[nodiscard]] bool IsExitAt(const uint64_t step) const noexcept
+    {
+        if (step < start) return std::ranges::binary_search(tailExits, step);
+        return std::ranges::binary_search(cycleExits, step % length);
+    }
+};
+
+static GhostCycle AnalyzeGhost(const Network& network, const std::vector<Movement>& movements, const uint16_t from)
+{
+    struct State
+    {
+        uint16_t node;
+        uint32_t movement;
+
+        bool operator==(const State&) const = default;
+    };
+
+    const auto next = [&](const State& state)
+    {
+        const uint32_t movement = state.movement + 1 == movements.size() ? 0 : state.movement + 1;
+        return State{ network.Next(state.node, movements[state.movement]), movement };
     };
 
-    throw std::exception();
+    const State initial{ from, 0 };
+
+    // Brent: buscamos la longitud del ciclo con potencias de dos crecientes...
+    uint64_t power = 1;
+    uint64_t length = 1;
+    State tortoise = initial;
+    State hare = next(initial);
+
+    while (tortoise != hare)
+    {
+        if (power == length)
+        {
+            tortoise = hare;
+            power *= 2;
+            length = 0;
+        }
+
+        hare = next(hare);
+        length++;
+    }
+
+    // ...y el inicio del ciclo avanzando dos punteros separados por su longitud.
+    tortoise = hare = initial;
+    for (uint64_t i = 0; i < length; i++) hare = next(hare);
+
+    uint64_t start = 0;
+    while (tortoise != hare)
+    {
+        tortoise = next(tortoise);
+        hare = next(hare);
+        start++;
+    }
+
+    GhostCycle cycle{ start, length, {}, {} };
+
+    State state = initial;
+    for (uint64_t step = 1; step < start + length; step++)
+    {
+        state = next(state);
+        if (network.Name(state.node).name[2] != 'Z') continue;
+
+        if (step < start) cycle.tailExits.push_back(step);
+        else cycle.cycleExits.push_back(step % length);
+    }
+
+    std::ranges::sort(cycle.cycleExits);
+    return cycle;
 }
 
-static uint32_t GetDistanceToExit(const Node& start, const NodeMap& nodeMap, const std::vector<char>& movements)
+struct Congruence
 {
-    Node currentNode = start;
-    std::pair<Node, Node> destinations = nodeMap.at(currentNode);
-
-    uint32_t steps = 0;
-    while (steps < 1'000'000) {
-        char movement = movements[steps % movements.size()];
-        
-        currentNode = movement == 'L' ? destinations.first : destinations.second;
-        steps++;
-
-        destinations = nodeMap.at(currentNode);
-        if (currentNode.name[2] == 'Z') return steps;
-    };
+    uint64_t remainder;
+    uint64_t modulus;
+};
+
+/**
+ * \brief Combina dos congruencias en una sola.
+ * \return La congruencia que cumplen ambas, o nada si son incompatibles.
+ */
+static std::optional<Congruence> Combine(const Congruence& a, const Congruence& b)
+{
+    // Resolvemos «a.modulus * k ≡ b.remainder - a.remainder (mod b.modulus)».
+    const uint64_t g = std::gcd(a.modulus, b.modulus);
+    const uint64_t difference = (b.remainder % b.modulus + b.modulus - a.remainder % b.modulus) % b.modulus;
+    if (difference % g != 0) return std::nullopt;
+
+    const uint64_t reducedModulus = b.modulus / g;
+    if (a.modulus > UINT64_MAX / reducedModulus) throw std::exception("El periodo común de los fantasmas no cabe en 64 bits");
 
-    throw std::exception();
+    // Inverso de «a.modulus / g» módulo «reducedModulus» con el algoritmo de Euclides extendido.
+    const int64_t mod = static_cast<int64_t>(reducedModulus);
+    int64_t oldR = static_cast<int64_t>(a.modulus / g % reducedModulus), r = mod;
+    int64_t oldS = 1, s = 0;
+    while (r != 0)
+    {
+        const int64_t quotient = oldR / r;
+        oldR = std::exchange(r, oldR - quotient * r);
+        oldS = std::exchange(s, oldS - quotient * s);
+    }
+
+    const uint64_t inverse = static_cast<uint64_t>((oldS % mod + mod) % mod);
+    const uint64_t k = static_cast<uint64_t>(static_cast<UInt128>(difference / g) * inverse % reducedModulus);
+
+    const uint64_t modulus = a.modulus * reducedModulus;
+    const uint64_t remainder = static_cast<uint64_t>((a.remainder + static_cast<UInt128>(a.modulus) * k) % modulus);
+
+    return Congruence{ remainder, modulus };
 }
 
 static uint64_t Second(
-    const NodeMap& nodeMap,
-    const std::vector<char>& movements,
-    const std::vector<Node>& edgeNodes
+    const Network& network,
+    const std::vector<Movement>& movements,
+    const std::vector<uint16_t>& edgeNodes
 )
 {
-    std::vector<uint32_t> distances;
-    std::ranges::transform(edgeNodes, std::back_inserter(distances), [&](const Node& node) {
-        return GetDistanceToExit(node, nodeMap, movements);
-    });
+    if (edgeNodes.empty()) throw std::exception("La red no tiene nodos que terminen en A");
+
+    std::vector<GhostCycle> cycles(edgeNodes.size());
 
-    uint64_t res = 1;
-    for (uint32_t distance : distances)
     {
-        assert(distance % MOVEMENTS_LENGTH == 0);
-        res = std::lcm(res, distance);
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < edgeNodes.size(); i++)
+            threads.emplace_back([&, i] { cycles[i] = AnalyzeGhost(network, movements, edgeNodes[i]); });
     }
 
+    const auto allAtExit = [&](const uint64_t step)
+    {
+        return std::ranges::all_of(cycles, [step](const GhostCycle& cycle) { return cycle.IsExitAt(step); });
+    };
+
+    // Pasos antes de que todos los fantasmas estén en su ciclo.
+    const uint64_t periodic = std::ranges::max(cycles | std::views::transform(&GhostCycle::start));
+    for (uint64_t step = 1; step < periodic; step++)
+        if (allAtExit(step)) return step;
+
+    // Combinamos los restos de cada fantasma con todos los obtenidos hasta ahora.
+    std::vector<Congruence> solutions = { { 0, 1 } };
+    for (const auto& cycle : cycles)
+    {
+        std::vector<Congruence> combined;
+        for (const auto& solution : solutions)
+            for (const uint64_t exit : cycle.cycleExits)
+                if (const auto congruence = Combine(solution, { exit, cycle.length }))
+                    combined.push_back(*congruence);
+
+        std::ranges::sort(combined, {}, &Congruence::remainder);
+        const auto [first, last] = std::ranges::unique(combined, {}, &Congruence::remainder);
+        combined.erase(first, last);
+
+        solutions = std::move(combined);
+    }
+
+    // El menor paso de cada solución que no sea anterior a los ciclos ni el inicial.
+    const uint64_t minimum = std::max<uint64_t>(periodic, 1);
+    uint64_t res = UINT64_MAX;
+
+    for (const auto& [remainder, modulus] : solutions)
+    {
+        uint64_t step = remainder;
+        if (step < minimum) step += (minimum - step + modulus - 1) / modulus * modulus;
+        res = std::min(res, step);
+    }
+
+    if (res == UINT64_MAX) throw std::exception("Los fantasmas nunca coinciden");
     return res;
 }
 
@@ -101,15 +431,18 @@ int main()
     using std::chrono::high_resolution_clock;
 
     const auto start = high_resolution_clock::now();
-    NodeMap nodeMap;
-    std::vector<char> movements;
-    std::vector<Node> edgeNodes;
+    Network network;
+    std::vector<Movement> movements;
+    std::vector<uint16_t> edgeNodes;
 
     {
         std::ifstream input("input", std::ios::binary);
 
-        movements.resize(MOVEMENTS_LENGTH);
-        input.read(movements.data(), MOVEMENTS_LENGTH);
+        std::string line;
+        std::getline(input, line);
+        for (const char c : line)
+            if (c == 'L' || c == 'R') movements.push_back(c == 'L' ? Left : Right);
+
         input >> std::ws;
 
         while (!input.eof())
@@ -124,17 +457,16 @@ int main()
             input.read(right.name, 3);
             input.ignore(2);
 
-            nodeMap[node] = std::make_pair(left, right);
+            network.Connect(node, left, right);
 
-            if (node.name[2] == 'A' || node.name[2] == 'Z')
-                edgeNodes.emplace_back(node);
+            if (node.name[2] == 'A')
+                edgeNodes.emplace_back(network.Find(node));
         }
     }
 
-    std::cout << "Primera parte: " << First(nodeMap, movements) << std::endl;
-    std::cout << "Segunda parte: " << Second(nodeMap, movements, edgeNodes) << std::endl;
+    std::cout << "Primera parte: " << First(network, movements) << std::endl;
+    std::cout << "Segunda parte: " << Second(network, movements, edgeNodes) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;
 }
-
@@ -1,64 +1,426 @@
 #include <array>
 #include <vector>
+#include <string>
+#include <span>
+#include <charconv>
+#include <memory>
 #include <algorithm>
+#include <bit>
+#include <cassert>
 #include <chrono>
 #include <fstream>
 #include <iostream>
-constexpr size_t DEGREE = 20;
-constexpr size_t TERMS = DEGREE + 1;
 
-typedef std::array<int64_t, TERMS> Points;
-typedef std::vector<Points> PointsVec;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
-static int64_t First(const PointsVec& pointsVec)
+#include "../Compartido/Int128.h"
+
+/*
+ * La pirámide de diferencias de una secuencia de «n» valores siempre termina en cero tras «n»
+ * niveles, así que la extrapolación es la de un polinomio de grado menor que «n». Esto equivale
+ * a que la diferencia «n»-ésima es cero:
+ *
+ *     sum_{i=0}^{n} (-1)^(n-i) C(n, i) x_i = 0
+ *
+ * Despejando el siguiente valor, o el anterior desplazando los índices, ambos son productos
+ * escalares de la secuencia con coeficientes binomiales con signo:
+ *
+ *     siguiente = sum_i (-1)^(n-1-i) C(n, i) x_i
+ *     anterior  = sum_i (-1)^i C(n, i+1) x_i
+ */
+
+/**
+ * \brief Calcula los coeficientes del siguiente y del anterior valor de una secuencia.
+ * \param length la longitud de la secuencia.
+ * \param next el vector donde se escriben los coeficientes del siguiente valor.
+ * \param previous el vector donde se escriben los coeficientes del valor anterior.
+ */
+template<typename T, typename Coefficients>
+constexpr void FillCoefficients(const size_t length, Coefficients& next, Coefficients& previous)
 {
-    int64_t res = 0;
-    Points pointsBuff;
-    for (const auto& points : pointsVec)
+    // Construimos la fila del triángulo de Pascal sumando, para no desbordar con productos.
+    std::vector<T> row(length + 1);
+    row[0] = 1;
+    for (size_t n = 1; n <= length; n++)
+        for (size_t k = n; k > 0; k--)
+            row[k] = row[k] + row[k - 1];
+
+    for (size_t i = 0; i < length; i++)
     {
-        pointsBuff = points;
-        size_t size = points.size() - 1;
-        while (std::any_of(pointsBuff.begin(), pointsBuff.begin() + size, [](int64_t point) { return point != 0; }))
+        next[i] = (length - 1 - i) % 2 == 0 ? row[i] : -row[i];
+        previous[i] = i % 2 == 0 ? row[i + 1] : -row[i + 1];
+    }
+}
+
+/*
+ * El resultado está acotado por el mayor valor absoluto de la secuencia multiplicado por la
+ * suma de los coeficientes, «2^n». Si esa cota cabe en 64 bits usamos el cálculo vectorial, que
+ * trabaja módulo 2^64; como el resultado cabe, es exacto aunque los productos intermedios
+ * desborden. Si no, usamos enteros de 128 bits.
+ *
+ * La cota es muy holgada: «1 2 ... 130» no la cumple ni en 128 bits, aunque su extrapolación es
+ * «131». Esas secuencias se resuelven construyendo la pirámide de diferencias con restas de
+ * 128 bits comprobadas, de forma que sólo es un error si algún valor desborda de verdad.
+ */
+
+constexpr size_t FAST_BITS = 62;
+constexpr size_t WIDE_BITS = 126;
+
+constexpr Int128 INT128_MAX = (static_cast<Int128>(1) << 126) - 1 + (static_cast<Int128>(1) << 126);
+constexpr Int128 INT128_MIN = -INT128_MAX - 1;
+
+/**
+ * \brief Suma dos enteros de 128 bits, comprobando que el resultado no desborda.
+ */
+[[nodiscard]] inline Int128 CheckedAdd(const Int128 a, const Int128 b)
+{
+    if ((b > 0 && a > INT128_MAX - b) || (b < 0 && a < INT128_MIN - b))
+        throw std::exception("La extrapolación no cabe en 128 bits");
+
+    return a + b;
+}
+
+/**
+ * \brief Resta dos enteros de 128 bits, comprobando que el resultado no desborda.
+ */
+[[nodiscard]] inline Int128 CheckedSubtract(const Int128 a, const Int128 b)
+{
+    if ((b < 0 && a > INT128_MAX + b) || (b > 0 && a < INT128_MIN + b))
+        throw std::exception("La extrapolación no cabe en 128 bits");
+
+    return a - b;
+}
+
+struct BinomialTable
+{
+    std::vector<int64_t> next;
+    std::vector<int64_t> previous;
+    std::vector<Int128> wideNext;
+    std::vector<Int128> widePrevious;
+
+    explicit BinomialTable(const size_t length) : wideNext(length), widePrevious(length)
+    {
+        FillCoefficients<Int128>(length, wideNext, widePrevious);
+
+        if (length <= FAST_BITS)
         {
-            for (size_t i = 0; i < size; i++)
-                pointsBuff[i] = pointsBuff[i + 1] - pointsBuff[i];
+            std::ranges::transform(wideNext, std::back_inserter(next), [](const Int128 c) { return static_cast<int64_t>(c); });
+            std::ranges::transform(widePrevious, std::back_inserter(previous), [](const Int128 c) { return static_cast<int64_t>(c); });
+        }
+    }
+};
+
+class BinomialCache
+{
+    std::vector<std::unique_ptr<BinomialTable>> m_tables;
+
+public:
+    const BinomialTable& For(const size_t length)
+    {
+        assert(length <= WIDE_BITS);
+        if (m_tables.size() <= length) m_tables.resize(length + 1);
+
+        auto& table = m_tables[length];
+        if (!table) table = std::make_unique<BinomialTable>(length);
+
+        return *table;
+    }
+};
+
+// Las longitudes más habituales tienen su propia versión con los coeficientes calculados al
+// compilar, de forma que el bucle de cada secuencia se desenrolla por completo.
+template<size_t Length>
+struct FixedCoefficients
+{
+    std::array<int64_t, Length> next{};
+    std::array<int64_t, Length> previous{};
+};
+
+template<size_t Length>
+constexpr FixedCoefficients<Length> FIXED_COEFFICIENTS = []
+{
+    static_assert(Length <= FAST_BITS);
+
+    FixedCoefficients<Length> coefficients;
+    FillCoefficients<int64_t>(Length, coefficients.next, coefficients.previous);
+    return coefficients;
+}();
+
+/*
+ * Guardamos todas las secuencias seguidas en un único vector, con la posición de inicio de
+ * cada una en otro.
+ */
+
+class Histories
+{
+    std::vector<int64_t> m_values;
+    std::vector<size_t> m_offsets = { 0 };
+
+public:
+    void Push(const std::span<const int64_t> values)
+    {
+        m_values.insert(m_values.end(), values.begin(), values.end());
+        m_offsets.push_back(m_values.size());
+    }
+
+    [[nodiscard]] size_t Size() const noexcept { return m_offsets.size() - 1; }
+
+    [[nodiscard]] std::span<const int64_t> operator[](const size_t i) const noexcept
+    {
+        return std::span(m_values).subspan(m_offsets[i], m_offsets[i + 1] - m_offsets[i]);
+    }
+};
+
+struct Extrapolation
+{
+    Int128 next = 0;
+    Int128 previous = 0;
+};
+
+/*
+ * Para el cálculo vectorial copiamos las secuencias de la misma longitud por bloques en forma
+ * de estructura de arreglos: cada fila del bloque tiene el mismo término de «BATCH» secuencias,
+ * de forma que los productos escalares de varias secuencias se calculan a la vez.
+ */
+
+constexpr size_t BATCH = 64;
+
+#if defined(__AVX2__)
+/**
+ * \brief Multiplica cuatro enteros de 64 bits por un mismo factor, módulo 2^64.
+ * AVX2 no tiene multiplicación de 64 bits, así que combinamos los productos de las mitades.
+ */
+inline __m256i Multiply(const __m256i x, const uint64_t factor) noexcept
+{
+    const __m256i low = _mm256_set1_epi64x(static_cast<int64_t>(factor & UINT32_MAX));
+    const __m256i high = _mm256_set1_epi64x(static_cast<int64_t>(factor >> 32));
+
+    const __m256i lowProduct = _mm256_mul_epu32(x, low);
+    const __m256i crossProducts = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(x, 32), low),
+        _mm256_mul_epu32(x, high)
+    );
+
+    return _mm256_add_epi64(lowProduct, _mm256_slli_epi64(crossProducts, 32));
+}
+#endif
+
+/**
+ * \brief Extrapola un bloque de secuencias de la misma longitud.
+ * \tparam Length la longitud de las secuencias, o «0» si sólo se conoce en ejecución.
+ * \param block los términos de las secuencias, «BATCH» por fila.
+ * \param length la longitud de las secuencias.
+ * \param nextCoefficients los coeficientes del siguiente valor.
+ * \param previousCoefficients los coeficientes del valor anterior.
+ * \param next el vector donde se escribe el siguiente valor de cada secuencia.
+ * \param previous el vector donde se escribe el valor anterior de cada secuencia.
+ */
+template<size_t Length>
+static void ExtrapolateBlock(
+    const int64_t* block,
+    const size_t length,
+    const int64_t* nextCoefficients,
+    const int64_t* previousCoefficients,
+    int64_t* next,
+    int64_t* previous
+)
+{
+    static_assert(BATCH % 4 == 0);
+
+    const size_t terms = Length != 0 ? Length : length;
+    size_t lane = 0;
 
-            size--;
+#if defined(__AVX2__)
+    for (; lane + 4 <= BATCH; lane += 4)
+    {
+        __m256i nextSum = _mm256_setzero_si256();
+        __m256i previousSum = _mm256_setzero_si256();
+
+        for (size_t t = 0; t < terms; t++)
+        {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + t * BATCH + lane));
+            nextSum = _mm256_add_epi64(nextSum, Multiply(x, static_cast<uint64_t>(nextCoefficients[t])));
+            previousSum = _mm256_add_epi64(previousSum, Multiply(x, static_cast<uint64_t>(previousCoefficients[t])));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(next + lane), nextSum);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(previous + lane), previousSum);
+    }
+#else
+    // Sumamos con aritmética módulo 2^64, igual que las instrucciones vectoriales.
+    for (; lane < BATCH; lane++)
+    {
+        uint64_t nextSum = 0;
+        uint64_t previousSum = 0;
+
+        for (size_t t = 0; t < terms; t++)
+        {
+            const uint64_t x = static_cast<uint64_t>(block[t * BATCH + lane]);
+            nextSum += x * static_cast<uint64_t>(nextCoefficients[t]);
+            previousSum += x * static_cast<uint64_t>(previousCoefficients[t]);
         }
 
-        // Nos podemos saltar la primera iteración, ya que siempre es 0
-        for (size_t i = size + 1; i < points.size(); i++)
-            pointsBuff[i] += pointsBuff[i - 1];
+        next[lane] = static_cast<int64_t>(nextSum);
+        previous[lane] = static_cast<int64_t>(previousSum);
+    }
+#endif
+}
+
+/**
+ * \brief Extrapola una secuencia con la pirámide de diferencias, comprobando cada resta.
+ * El siguiente valor es la suma de los últimos de cada nivel, y el anterior la suma de los
+ * primeros con signos alternos.
+ */
+static Extrapolation ExtrapolateExact(const std::span<const int64_t> values)
+{
+    std::vector<Int128> level(values.begin(), values.end());
+    Extrapolation res;
+    bool negate = false;
+
+    while (std::ranges::any_of(level, [](const Int128 value) { return value != 0; }))
+    {
+        res.next = CheckedAdd(res.next, level.back());
+        res.previous = negate ? CheckedSubtract(res.previous, level.front()) : CheckedAdd(res.previous, level.front());
+        negate = !negate;
+
+        for (size_t t = 0; t + 1 < level.size(); t++)
+            level[t] = CheckedSubtract(level[t + 1], level[t]);
 
-        res += pointsBuff.back();
+        level.pop_back();
     }
 
     return res;
 }
 
-static int64_t Second(const PointsVec& pointsVec)
+/**
+ * \brief Extrapola el siguiente y el anterior valor de todas las secuencias y devuelve
+ * la suma de cada uno.
+ */
+static Extrapolation Extrapolate(const Histories& histories)
 {
-    int64_t res = 0;
-    Points pointsBuff;
-    for (const auto& points : pointsVec)
+    BinomialCache cache;
+    Extrapolation res;
+
+    // Repartimos las secuencias por longitud, y aparte las que necesitan 128 bits y las que
+    // necesitan la pirámide de diferencias. Las que son todo ceros se extrapolan a cero y no
+    // hace falta calcularlas.
+    std::vector<std::vector<size_t>> byLength;
+    std::vector<size_t> wide;
+    std::vector<size_t> exact;
+
+    for (size_t i = 0; i < histories.Size(); i++)
+    {
+        const auto values = histories[i];
+
+        uint64_t maxAbs = 0;
+        for (const int64_t value : values)
+            maxAbs = std::max(maxAbs, value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value));
+
+        if (maxAbs == 0) continue;
+
+        const size_t bits = std::bit_width(maxAbs) + values.size();
+        if (bits <= FAST_BITS)
+        {
+            if (byLength.size() <= values.size()) byLength.resize(values.size() + 1);
+            byLength[values.size()].push_back(i);
+        }
+        else if (bits <= WIDE_BITS) wide.push_back(i);
+        else exact.push_back(i);
+    }
+
+    std::vector<int64_t> rows;
+    int64_t next[BATCH];
+    int64_t previous[BATCH];
+
+    for (size_t length = 1; length < byLength.size(); length++)
     {
-        pointsBuff = points;
-        size_t offset = 0;
-        while (std::any_of(pointsBuff.begin() + offset, pointsBuff.end(), [](int64_t point) { return point != 0; }))
+        const auto& indices = byLength[length];
+        const BinomialTable& table = cache.For(length);
+
+        for (size_t first = 0; first < indices.size(); first += BATCH)
         {
-            for (size_t i = points.size() - 1; i > offset; i--)
-                pointsBuff[i] -= pointsBuff[i - 1];
+            const size_t count = std::min(BATCH, indices.size() - first);
 
-            offset++;
+            // Rellenamos con ceros las posiciones sobrantes.
+            rows.assign(length * BATCH, 0);
+
+            for (size_t lane = 0; lane < count; lane++)
+            {
+                const auto values = histories[indices[first + lane]];
+                for (size_t t = 0; t < length; t++)
+                    rows[t * BATCH + lane] = values[t];
+            }
+
+            switch (length)
+            {
+            case 6:
+                ExtrapolateBlock<6>(rows.data(), length, FIXED_COEFFICIENTS<6>.next.data(), FIXED_COEFFICIENTS<6>.previous.data(), next, previous);
+                break;
+
+            case 21:
+                ExtrapolateBlock<21>(rows.data(), length, FIXED_COEFFICIENTS<21>.next.data(), FIXED_COEFFICIENTS<21>.previous.data(), next, previous);
+                break;
+
+            default:
+                ExtrapolateBlock<0>(rows.data(), length, table.next.data(), table.previous.data(), next, previous);
+                break;
+            }
+
+            for (size_t lane = 0; lane < count; lane++)
+            {
+                res.next = CheckedAdd(res.next, next[lane]);
+                res.previous = CheckedAdd(res.previous, previous[lane]);
+            }
+        }
+    }
+
+    for (const size_t i : wide)
+    {
+        const auto values = histories[i];
+        const BinomialTable& table = cache.For(values.size());
+
+        // Cada producto y la suma de la secuencia caben en «WIDE_BITS» bits.
+        Extrapolation sequence;
+        for (size_t t = 0; t < values.size(); t++)
+        {
+            sequence.next += table.wideNext[t] * values[t];
+            sequence.previous += table.widePrevious[t] * values[t];
         }
 
-        // Nos podemos saltar la primera iteración, ya que siempre es 0
-        for (size_t i = offset - 1; i + 1 > 0; i--)
-            pointsBuff[i] -= pointsBuff[i + 1];
+        res.next = CheckedAdd(res.next, sequence.next);
+        res.previous = CheckedAdd(res.previous, sequence.previous);
+    }
+
+    for (const size_t i : exact)
+    {
+        const Extrapolation sequence = ExtrapolateExact(histories[i]);
+        res.next = CheckedAdd(res.next, sequence.next);
+        res.previous = CheckedAdd(res.previous, sequence.previous);
+    }
+
+    return res;
+}
 
-        res += pointsBuff.front();
+/**
+ * \brief Convierte un entero de 128 bits en texto.
+ */
+std::string ToString(const Int128 value)
+{
+    Int128 magnitude = value < 0 ? -value : value;
+
+    std::string res;
+    do
+    {
+        res += static_cast<char>('0' + static_cast<int32_t>(magnitude % 10));
+        magnitude /= 10;
     }
+    while (magnitude != 0);
 
+    if (value < 0) res += '-';
+
+    std::ranges::reverse(res);
     return res;
 }
 
@@ -70,22 +432,40 @@ int main()
 
     const auto start = high_resolution_clock::now();
 
-    PointsVec pointsVec;
+    Histories histories;
     {
         std::ifstream input("input", std::ios::binary);
 
-        while (!input.eof())
+        std::string line;
+        std::vector<int64_t> values;
+
+        while (std::getline(input, line))
         {
-            Points points;
-            for (auto& point : points)
-                input >> point >> std::ws;
+            values.clear();
+
+            const char* first = line.data();
+            const char* last = line.data() + line.size();
+
+            while (first != last)
+            {
+                if (*first == ' ' || *first == '\r') { first++; continue; }
 
-            pointsVec.emplace_back(points);
+                int64_t value = 0;
+                const auto [ptr, error] = std::from_chars(first, last, value);
+                if (error != std::errc()) throw std::exception("Número no válido");
+
+                first = ptr;
+                values.push_back(value);
+            }
+
+            if (!values.empty()) histories.Push(values);
         }
     }
 
-    std::cout << "Primera parte: " << First(pointsVec) << std::endl;
-    std::cout << "Segunda parte: " << Second(pointsVec) << std::endl;
+    const auto [next, previous] = Extrapolate(histories);
+
+    std::cout << "Primera parte: " << ToString(next) << std::endl;
+    std::cout << "Segunda parte: " << ToString(previous) << std::endl;
 
     const auto elapsed = high_resolution_clock::now() - start;
     std::cout << "Duración total: " << duration_cast<milliseconds>(elapsed) << std::endl;